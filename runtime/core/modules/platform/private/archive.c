@@ -0,0 +1,352 @@
+
+// Copyright (c) 2025 Lenny Siebert
+//
+// This software is dual-licensed:
+//
+// 1. Open Source License:
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License version 3
+//    as published by the Free Software Foundation.
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY. See the GNU General Public
+//    License for more details: https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// 2. Commercial License:
+//    A commercial license will be available at a later time for use in commercial products.
+
+#include "archive.h"
+#include "common.h"
+#include "directory.h"
+#include <stdalign.h>
+
+
+#define ARCHIVE_MAGIC "FWARCHIV"
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_ALIGNMENT 64
+
+/**
+ * @brief Start of every archive.
+ *
+ * The data of the assets follows the header, the table of contents
+ * is written behind it as entries, slots and the names of the assets.
+ */
+struct header_s {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint64_t entries;
+    uint64_t slots;
+    uint64_t names;
+    uint64_t names_size;
+    uint32_t slot_count;
+    uint32_t reserved;
+};
+
+/**
+ * @brief An asset in the table of contents, sorted by name.
+ */
+struct entry_s {
+    uint64_t hash;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t name;
+    uint32_t name_length;
+};
+
+/**
+ * @brief The slots are an open addressing table of entry indices plus one.
+ */
+struct archive_s {
+    file_view_t view;
+    const struct entry_s* entries;
+    const uint32_t* slots;
+    const char* names;
+    uint32_t count;
+    uint32_t slot_count;
+};
+
+static uint64_t hash_path(const char* path, const size_t length) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)path[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static int compare_names(const void* a, const void* b) {
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+static bool write_padding(FILE* file, uint64_t* offset) {
+    static const char zeros[ARCHIVE_ALIGNMENT] = { 0 };
+    const size_t padding = -*offset & (ARCHIVE_ALIGNMENT - 1);
+    *offset += padding;
+    return fwrite(zeros, 1, padding, file) == padding;
+}
+
+/**
+ * @brief Writes the content of the asset files behind each other.
+ */
+static bool pack_data(
+    FILE* file, const char* dir_path, const size_t dir_length,
+    char** names, struct entry_s* entries, const uint32_t count,
+    uint64_t* offset
+) {
+    char* path = NULL;
+    size_t path_capacity = 0;
+    bool result = true;
+    for (uint32_t i = 0; i < count && result; i++) {
+        const size_t name_length = strlen(names[i]);
+        if (dir_length + name_length + 2 > path_capacity) {
+            path_capacity = (dir_length + name_length + 2) * 2;
+            char* grown = realloc(path, path_capacity);
+            if (!grown) {
+                result = false;
+                break;
+            }
+            path = grown;
+        }
+        memcpy(path, dir_path, dir_length);
+        path[dir_length] = '/';
+        memcpy(path + dir_length + 1, names[i], name_length + 1);
+
+        file_view_t view;
+        if (!fview(&view, path)) {
+            fprintf(stderr, "Asset %s cannot be read for packing.\n", path);
+            result = false;
+            break;
+        }
+        result = write_padding(file, offset) &&
+            fwrite(view.data, 1, view.size, file) == view.size;
+        entries[i].offset = *offset;
+        entries[i].size = view.size;
+        *offset += view.size;
+        fview_release(&view);
+    }
+    free(path);
+    return result;
+}
+
+bool archive_pack(const char* archive_path, const char* dir_path) {
+    dir_listing_t listing;
+    if (!dir_walk(&listing, dir_path, true, 1)) {
+        fprintf(stderr, "Assets of %s cannot be listed for packing.\n", dir_path);
+        return false;
+    }
+
+    // The names are the paths of the files inside of the directory.
+    size_t dir_length = strlen(dir_path);
+    while (dir_length > 1 &&
+        (dir_path[dir_length - 1] == '/' || dir_path[dir_length - 1] == '\\')
+    ) dir_length--;
+
+    char** names = malloc((listing.count + 1) * sizeof(char*));
+    uint32_t count = 0;
+    for (size_t i = 0; names && i < listing.count; i++) {
+        if (listing.entries[i].type != entry_file) continue;
+        char* name = (char*)listing.entries[i].path + dir_length + 1;
+        for (char* c = name; *c; c++) if (*c == '\\') *c = '/';
+        names[count++] = name;
+    }
+    if (names) qsort(names, count, sizeof(char*), compare_names);
+
+    uint32_t slot_count = 16;
+    while (slot_count < count * 2) slot_count *= 2;
+    struct entry_s* entries = calloc(count + 1, sizeof(struct entry_s));
+    uint32_t* slots = calloc(slot_count, sizeof(uint32_t));
+    FILE* file = fopen(archive_path, "wb");
+
+    struct header_s header = {
+        .magic = ARCHIVE_MAGIC,
+        .version = ARCHIVE_VERSION,
+        .count = count,
+        .slot_count = slot_count
+    };
+    uint64_t offset = sizeof(header);
+    bool result = names && entries && slots && file &&
+        fwrite(&header, sizeof(header), 1, file) == 1 &&
+        pack_data(file, dir_path, dir_length, names, entries, count, &offset);
+
+    // The table of contents is known after the data is written.
+    uint32_t names_size = 0;
+    for (uint32_t i = 0; result && i < count; i++) {
+        const size_t length = strlen(names[i]);
+        entries[i].hash = hash_path(names[i], length);
+        entries[i].name = names_size;
+        entries[i].name_length = length;
+        names_size += length + 1;
+
+        uint32_t slot = entries[i].hash & (slot_count - 1);
+        while (slots[slot]) slot = (slot + 1) & (slot_count - 1);
+        slots[slot] = i + 1;
+    }
+
+    if (result) {
+        result = write_padding(file, &offset);
+        header.entries = offset;
+        header.slots = header.entries + count * sizeof(struct entry_s);
+        header.names = header.slots + slot_count * sizeof(uint32_t);
+        header.names_size = names_size;
+        result = result &&
+            fwrite(entries, sizeof(struct entry_s), count, file) == count &&
+            fwrite(slots, sizeof(uint32_t), slot_count, file) == slot_count;
+    }
+    for (uint32_t i = 0; result && i < count; i++)
+        result = fwrite(names[i], 1, entries[i].name_length + 1, file) ==
+            entries[i].name_length + 1;
+    result = result && fseek(file, 0, SEEK_SET) == 0 &&
+        fwrite(&header, sizeof(header), 1, file) == 1;
+
+    if (file) result = fclose(file) == 0 && result;
+    if (!result) {
+        perror("Archive cannot be packed");
+        if (file) remove(archive_path);
+    }
+    free(slots);
+    free(entries);
+    free(names);
+    dir_listing_release(&listing);
+    return result;
+}
+
+/**
+ * @brief Tests if every part of the archive is inside of the file.
+ *
+ * The slots need at least one empty slot, otherwise looking for a
+ * missing path would never end.
+ */
+static bool archive_valid(const archive_t* archive, const struct header_s* header) {
+    const uint64_t size = archive->view.size;
+    if (header->slot_count == 0 ||
+        header->slot_count & (header->slot_count - 1) ||
+        header->slot_count <= header->count ||
+        header->entries % alignof(struct entry_s) ||
+        header->entries > size ||
+        (size - header->entries) / sizeof(struct entry_s) < header->count ||
+        header->slots != header->entries + header->count * sizeof(struct entry_s) ||
+        (size - header->slots) / sizeof(uint32_t) < header->slot_count ||
+        header->names != header->slots + header->slot_count * sizeof(uint32_t) ||
+        size - header->names < header->names_size
+    ) return false;
+
+    bool has_empty = false;
+    for (uint32_t i = 0; i < header->slot_count; i++) {
+        if (archive->slots[i] > header->count) return false;
+        if (!archive->slots[i]) has_empty = true;
+    }
+    if (!has_empty) return false;
+    for (uint32_t i = 0; i < header->count; i++) {
+        const struct entry_s* entry = &archive->entries[i];
+        if (entry->offset > size || size - entry->offset < entry->size ||
+            entry->name >= header->names_size ||
+            header->names_size - entry->name <= entry->name_length ||
+            archive->names[entry->name + entry->name_length] != '\0'
+        ) return false;
+    }
+    return true;
+}
+
+archive_t* archive_open(const char* path) {
+    archive_t* archive = malloc(sizeof(archive_t));
+    if (!archive) return NULL;
+    if (!fview(&archive->view, path)) {
+        free(archive);
+        return NULL;
+    }
+
+    struct header_s header;
+    bool result = archive->view.size >= sizeof(header);
+    if (result) {
+        memcpy(&header, archive->view.data, sizeof(header));
+        result = memcmp(header.magic, ARCHIVE_MAGIC, sizeof(header.magic)) == 0 &&
+            header.version == ARCHIVE_VERSION;
+    }
+    if (result) {
+        archive->entries = (const void*)(archive->view.data + header.entries);
+        archive->slots = (const void*)(archive->view.data + header.slots);
+        archive->names = archive->view.data + header.names;
+        archive->count = header.count;
+        archive->slot_count = header.slot_count;
+        result = archive_valid(archive, &header);
+    }
+    if (result) return archive;
+
+    fprintf(stderr, "Archive %s is damaged or not an archive.\n", path);
+    fview_release(&archive->view);
+    free(archive);
+    return NULL;
+}
+
+bool archive_find(
+    const archive_t* archive, const char* path, archive_asset_t* asset
+) {
+    const size_t length = strlen(path);
+    const uint64_t hash = hash_path(path, length);
+    const uint32_t mask = archive->slot_count - 1;
+    for (uint32_t slot = hash & mask;; slot = (slot + 1) & mask) {
+        const uint32_t index = archive->slots[slot];
+        if (!index) return false;
+
+        const struct entry_s* entry = &archive->entries[index - 1];
+        if (entry->hash == hash && entry->name_length == length &&
+            memcmp(archive->names + entry->name, path, length) == 0
+        ) {
+            archive_at(archive, index - 1, asset);
+            return true;
+        }
+    }
+}
+
+size_t archive_count(const archive_t* archive) {
+    return archive->count;
+}
+
+void archive_at(
+    const archive_t* archive, const size_t index, archive_asset_t* asset
+) {
+    const struct entry_s* entry = &archive->entries[index];
+    *asset = (archive_asset_t) {
+        .path = archive->names + entry->name,
+        .path_length = entry->name_length,
+        .data = archive->view.data + entry->offset,
+        .size = entry->size
+    };
+}
+
+/**
+ * @brief Gets the index of the first name not ordered before the prefix.
+ */
+static size_t lower_bound(
+    const archive_t* archive, const char* prefix, const size_t length
+) {
+    size_t low = 0;
+    size_t high = archive->count;
+    while (low < high) {
+        const size_t middle = low + (high - low) / 2;
+        const struct entry_s* entry = &archive->entries[middle];
+        if (strncmp(archive->names + entry->name, prefix, length) < 0)
+            low = middle + 1;
+        else high = middle;
+    }
+    return low;
+}
+
+size_t archive_prefix(
+    const archive_t* archive, const char* prefix, size_t* first
+) {
+    const size_t length = strlen(prefix);
+    *first = lower_bound(archive, prefix, length);
+
+    size_t last = *first;
+    while (last < archive->count && strncmp(
+        archive->names + archive->entries[last].name, prefix, length
+    ) == 0) last++;
+    return last - *first;
+}
+
+void archive_del(archive_t* archive) {
+    if (!archive) return;
+    fview_release(&archive->view);
+    free(archive);
+}
@@ -0,0 +1,134 @@
+
+// Copyright (c) 2025 Lenny Siebert
+//
+// This software is dual-licensed:
+//
+// 1. Open Source License:
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License version 3
+//    as published by the Free Software Foundation.
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY. See the GNU General Public
+//    License for more details: https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// 2. Commercial License:
+//    A commercial license will be available at a later time for use in commercial products.
+
+#include "arena.h"
+#include <stdalign.h>
+
+
+/**
+ * @brief A block of memory, the data follows the header.
+ *
+ * The used size is the offset of the free rest of the block.
+ */
+struct block_s {
+    struct block_s* next;
+    size_t size;
+    size_t used;
+    alignas(max_align_t) unsigned char data[];
+};
+
+struct arena_s {
+    struct block_s* blocks;
+    size_t block_size;
+};
+
+static struct block_s* block_create(const size_t size) {
+    struct block_s* block = malloc(sizeof(struct block_s) + size);
+    if (!block) {
+        perror("Failed to allocate arena block");
+        return NULL;
+    }
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+arena_t* arena_create(const size_t block_size) {
+    arena_t* arena = malloc(sizeof(arena_t));
+    if (!arena) {
+        perror("Failed to create arena");
+        return NULL;
+    }
+    *arena = (arena_t) {
+        .blocks = NULL,
+        .block_size = block_size ? block_size : 64 * 1024
+    };
+    return arena;
+}
+
+/**
+ * @brief Takes aligned memory from the free rest of the block.
+ */
+static void* block_take(
+    struct block_s* block, const size_t size, const size_t alignment
+) {
+    const uintptr_t start = (uintptr_t)(block->data + block->used);
+    const size_t offset = block->used +
+        ((alignment - start % alignment) & (alignment - 1));
+    if (offset > block->size || block->size - offset < size) return NULL;
+    block->used = offset + size;
+    return block->data + offset;
+}
+
+void* arena_alloc(arena_t* arena, const size_t size, const size_t alignment) {
+    struct block_s* block = arena->blocks;
+    if (block) {
+        void* memory = block_take(block, size, alignment);
+        if (memory) return memory;
+    }
+
+    // Large allocations get a block of their own behind the current one,
+    // so the rest of the current block is not wasted.
+    const size_t needed = size + alignment;
+    if (needed > arena->block_size / 4) {
+        struct block_s* large = block_create(needed);
+        if (!large) return NULL;
+        if (block) {
+            large->next = block->next;
+            block->next = large;
+        } else arena->blocks = large;
+        return block_take(large, size, alignment);
+    }
+
+    block = block_create(arena->block_size);
+    if (!block) return NULL;
+    block->next = arena->blocks;
+    arena->blocks = block;
+    return block_take(block, size, alignment);
+}
+
+char* arena_strndup(arena_t* arena, const char* string, const size_t length) {
+    char* copy = arena_alloc(arena, length + 1, 1);
+    if (!copy) return NULL;
+    memcpy(copy, string, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+void arena_adopt(arena_t* destination, arena_t* source) {
+    struct block_s* last = source->blocks;
+    if (last) {
+        while (last->next) last = last->next;
+        if (destination->blocks) {
+            // The current block of the destination stays in front.
+            last->next = destination->blocks->next;
+            destination->blocks->next = source->blocks;
+        } else destination->blocks = source->blocks;
+    }
+    free(source);
+}
+
+void arena_del(arena_t* arena) {
+    if (!arena) return;
+    struct block_s* block = arena->blocks;
+    while (block) {
+        struct block_s* next = block->next;
+        free(block);
+        block = next;
+    }
+    free(arena);
+}
@@ -0,0 +1,468 @@
+
+// Copyright (c) 2025 Lenny Siebert
+//
+// This software is dual-licensed:
+//
+// 1. Open Source License:
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License version 3
+//    as published by the Free Software Foundation.
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY. See the GNU General Public
+//    License for more details: https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// 2. Commercial License:
+//    A commercial license will be available at a later time for use in commercial products.
+
+#include "async_io.h"
+#include <errno.h>
+#include <stdatomic.h>
+#include <threads.h>
+
+
+/**
+ * @brief The mapped rings of an io_uring instance.
+ */
+struct uring_s {
+    int fd;
+    unsigned unsubmitted;
+    _Atomic unsigned* sq_head;
+    _Atomic unsigned* sq_tail;
+    unsigned sq_mask;
+    unsigned* sq_array;
+    _Atomic unsigned* cq_head;
+    _Atomic unsigned* cq_tail;
+    unsigned cq_mask;
+    void* sqes;
+    void* cqes;
+    void* sq_map;
+    size_t sq_map_size;
+    void* cq_map;
+    size_t cq_map_size;
+    size_t sqes_size;
+};
+
+/**
+ * @brief The engine, either with an io_uring instance or a pool of threads.
+ *
+ * Pending requests wait for a thread in a ring buffer, completed
+ * requests wait to be polled. Both can hold the depth, because the
+ * in flight count never exceeds it.
+ */
+struct async_io_s {
+    size_t depth;
+    size_t in_flight;
+    bool uring;
+    struct uring_s ring;
+
+    thrd_t* threads;
+    size_t thread_count;
+    mtx_t lock;
+    cnd_t work;
+    cnd_t complete;
+    bool running;
+    io_request_t** pending;
+    size_t pending_head;
+    size_t pending_count;
+    io_request_t** completed;
+    size_t completed_count;
+    io_request_t** reaped;
+};
+
+static void finish(io_request_t* request) {
+    request->done = true;
+    if (request->callback) request->callback(request);
+}
+
+
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static bool uring_create(struct uring_s* ring, const unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring->fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0) return false;
+
+    // Plain read and write operations came with Linux 5.6,
+    // fast poll is the first feature flag after them.
+    if (!(params.features & IORING_FEAT_FAST_POLL)) {
+        close(ring->fd);
+        return false;
+    }
+    ring->unsubmitted = 0;
+
+    ring->sq_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_map_size = params.cq_off.cqes +
+        params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_map_size > ring->sq_map_size)
+            ring->sq_map_size = ring->cq_map_size;
+        ring->cq_map_size = ring->sq_map_size;
+    }
+
+    ring->sq_map = mmap(
+        NULL, ring->sq_map_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING
+    );
+    if (ring->sq_map == MAP_FAILED) {
+        close(ring->fd);
+        return false;
+    }
+
+    ring->cq_map = ring->sq_map;
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP)) ring->cq_map = mmap(
+        NULL, ring->cq_map_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING
+    );
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(
+        NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES
+    );
+    if (ring->cq_map == MAP_FAILED || ring->sqes == MAP_FAILED) {
+        if (ring->cq_map != MAP_FAILED && ring->cq_map != ring->sq_map)
+            munmap(ring->cq_map, ring->cq_map_size);
+        if (ring->sqes != MAP_FAILED) munmap(ring->sqes, ring->sqes_size);
+        munmap(ring->sq_map, ring->sq_map_size);
+        close(ring->fd);
+        return false;
+    }
+
+    char* sq = ring->sq_map;
+    char* cq = ring->cq_map;
+    ring->sq_head = (_Atomic unsigned*)(sq + params.sq_off.head);
+    ring->sq_tail = (_Atomic unsigned*)(sq + params.sq_off.tail);
+    ring->sq_mask = *(unsigned*)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+    ring->cq_head = (_Atomic unsigned*)(cq + params.cq_off.head);
+    ring->cq_tail = (_Atomic unsigned*)(cq + params.cq_off.tail);
+    ring->cq_mask = *(unsigned*)(cq + params.cq_off.ring_mask);
+    ring->cqes = cq + params.cq_off.cqes;
+    return true;
+}
+
+static void uring_del(struct uring_s* ring) {
+    munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_map != ring->sq_map) munmap(ring->cq_map, ring->cq_map_size);
+    munmap(ring->sq_map, ring->sq_map_size);
+    close(ring->fd);
+}
+
+/**
+ * @brief Passes the filled submission entries to the kernel.
+ *
+ * Entries the kernel did not take yet stay in the ring
+ * and are passed by the next call.
+ *
+ * @return Returns zero or the negative error of the call.
+ */
+static int uring_enter(
+    struct uring_s* ring, const unsigned min_complete, const unsigned flags
+) {
+    while (true) {
+        const int result = syscall(
+            __NR_io_uring_enter, ring->fd, ring->unsubmitted,
+            min_complete, flags, NULL, 0
+        );
+        if (result >= 0) {
+            ring->unsubmitted -= result;
+            return 0;
+        }
+        if (errno != EINTR) return -errno;
+    }
+}
+
+/**
+ * @brief Fills a submission entry per request and submits them with one call.
+ */
+static size_t uring_submit(
+    struct uring_s* ring, io_request_t* const* requests, const size_t count
+) {
+    unsigned tail = atomic_load_explicit(ring->sq_tail, memory_order_relaxed);
+    const unsigned head = atomic_load_explicit(ring->sq_head, memory_order_acquire);
+
+    size_t queued = 0;
+    while (queued < count && tail - head <= ring->sq_mask) {
+        const io_request_t* request = requests[queued];
+        const unsigned index = tail & ring->sq_mask;
+        struct io_uring_sqe* sqe = (struct io_uring_sqe*)ring->sqes + index;
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = request->operation == io_read ?
+            IORING_OP_READ : IORING_OP_WRITE;
+        sqe->fd = request->file;
+        sqe->addr = (uintptr_t)request->buffer;
+        // The length has 32 bits, larger requests transfer less, like on Windows.
+        sqe->len = request->size > 0xFFFFFFFF ?
+            0xFFFFFFFF : (uint32_t)request->size;
+        sqe->off = request->offset;
+        sqe->user_data = (uintptr_t)request;
+        ring->sq_array[index] = index;
+        tail++;
+        queued++;
+    }
+    atomic_store_explicit(ring->sq_tail, tail, memory_order_release);
+
+    ring->unsubmitted += queued;
+    uring_enter(ring, 0, 0);
+    return queued;
+}
+
+static size_t uring_poll(async_io_t* io, const bool wait) {
+    struct uring_s* ring = &io->ring;
+    unsigned head = atomic_load_explicit(ring->cq_head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(ring->cq_tail, memory_order_acquire);
+    int failure = ring->unsubmitted ? uring_enter(ring, 0, 0) : 0;
+    while (wait && head == tail && !failure) {
+        failure = uring_enter(ring, 1, IORING_ENTER_GETEVENTS);
+        tail = atomic_load_explicit(ring->cq_tail, memory_order_acquire);
+    }
+
+    // The completions are copied out first, so a callback can submit again.
+    size_t count = 0;
+    for (; head != tail; head++) {
+        const struct io_uring_cqe* cqe =
+            (const struct io_uring_cqe*)ring->cqes + (head & ring->cq_mask);
+        io_request_t* request = (io_request_t*)(uintptr_t)cqe->user_data;
+        request->result = cqe->res;
+        io->reaped[count++] = request;
+    }
+    atomic_store_explicit(ring->cq_head, head, memory_order_release);
+
+    // Entries the kernel refuses for good are taken back and fail with
+    // its error, so nobody waits for them forever.
+    if (failure && failure != -EAGAIN && failure != -EBUSY && ring->unsubmitted) {
+        unsigned sq_tail = atomic_load_explicit(ring->sq_tail, memory_order_relaxed);
+        for (; ring->unsubmitted > 0; ring->unsubmitted--) {
+            sq_tail--;
+            const struct io_uring_sqe* sqe =
+                (const struct io_uring_sqe*)ring->sqes + (sq_tail & ring->sq_mask);
+            io_request_t* request = (io_request_t*)(uintptr_t)sqe->user_data;
+            request->result = failure;
+            io->reaped[count++] = request;
+        }
+        atomic_store_explicit(ring->sq_tail, sq_tail, memory_order_release);
+    }
+    return count;
+}
+
+#else
+
+static bool uring_create(struct uring_s* ring, const unsigned entries) {
+    (void)ring;
+    (void)entries;
+    return false;
+}
+
+static void uring_del(struct uring_s* ring) {
+    (void)ring;
+}
+
+static size_t uring_submit(
+    struct uring_s* ring, io_request_t* const* requests, const size_t count
+) {
+    (void)ring;
+    (void)requests;
+    (void)count;
+    return 0;
+}
+
+static size_t uring_poll(async_io_t* io, const bool wait) {
+    (void)io;
+    (void)wait;
+    return 0;
+}
+
+#endif
+
+
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+
+static int64_t perform(const io_request_t* request) {
+    const HANDLE handle = (HANDLE)_get_osfhandle(request->file);
+    OVERLAPPED position = {
+        .Offset = request->offset & 0xFFFFFFFF,
+        .OffsetHigh = request->offset >> 32
+    };
+    const DWORD size = request->size > 0xFFFFFFFF ?
+        0xFFFFFFFF : (DWORD)request->size;
+
+    DWORD transferred = 0;
+    const BOOL result = request->operation == io_read ?
+        ReadFile(handle, request->buffer, size, &transferred, &position) :
+        WriteFile(handle, request->buffer, size, &transferred, &position);
+    if (!result && GetLastError() != ERROR_HANDLE_EOF) return -EIO;
+    return transferred;
+}
+
+
+#else
+#include <unistd.h>
+
+static int64_t perform(const io_request_t* request) {
+    while (true) {
+        const ssize_t result = request->operation == io_read ?
+            pread(request->file, request->buffer, request->size, request->offset) :
+            pwrite(request->file, request->buffer, request->size, request->offset);
+        if (result >= 0) return result;
+        if (errno != EINTR) return -errno;
+    }
+}
+
+#endif
+
+
+
+/**
+ * @brief Performs pending requests until the engine is disposed.
+ */
+static int worker(void* argument) {
+    async_io_t* io = argument;
+    mtx_lock(&io->lock);
+    while (true) {
+        while (io->running && io->pending_count == 0)
+            cnd_wait(&io->work, &io->lock);
+        if (io->pending_count == 0) break;
+
+        io_request_t* request = io->pending[io->pending_head];
+        io->pending_head = (io->pending_head + 1) % io->depth;
+        io->pending_count--;
+        mtx_unlock(&io->lock);
+
+        request->result = perform(request);
+
+        mtx_lock(&io->lock);
+        io->completed[io->completed_count++] = request;
+        cnd_signal(&io->complete);
+    }
+    mtx_unlock(&io->lock);
+    return 0;
+}
+
+static size_t pool_submit(
+    async_io_t* io, io_request_t* const* requests, const size_t count
+) {
+    mtx_lock(&io->lock);
+    for (size_t i = 0; i < count; i++) {
+        const size_t index = (io->pending_head + io->pending_count) % io->depth;
+        io->pending[index] = requests[i];
+        io->pending_count++;
+    }
+    if (count > 1) cnd_broadcast(&io->work);
+    else cnd_signal(&io->work);
+    mtx_unlock(&io->lock);
+    return count;
+}
+
+static size_t pool_poll(async_io_t* io, const bool wait) {
+    mtx_lock(&io->lock);
+    while (wait && io->completed_count == 0)
+        cnd_wait(&io->complete, &io->lock);
+
+    const size_t count = io->completed_count;
+    memcpy(io->reaped, io->completed, count * sizeof(io_request_t*));
+    io->completed_count = 0;
+    mtx_unlock(&io->lock);
+    return count;
+}
+
+async_io_t* async_io_create(const size_t depth, size_t thread_count) {
+    async_io_t* io = calloc(1, sizeof(async_io_t));
+    if (!io) {
+        perror("Failed to create I/O engine");
+        return NULL;
+    }
+    io->depth = depth ? depth : 64;
+    io->reaped = malloc(io->depth * sizeof(io_request_t*));
+    if (!io->reaped) {
+        free(io);
+        return NULL;
+    }
+
+    io->uring = uring_create(&io->ring, io->depth);
+    if (io->uring) return io;
+
+    if (thread_count == 0) thread_count = 1;
+    io->pending = malloc(io->depth * sizeof(io_request_t*));
+    io->completed = malloc(io->depth * sizeof(io_request_t*));
+    io->threads = malloc(thread_count * sizeof(thrd_t));
+    io->running = true;
+    if (!io->pending || !io->completed || !io->threads ||
+        mtx_init(&io->lock, mtx_plain) != thrd_success
+    ) {
+        perror("Failed to create I/O engine");
+        free(io->pending);
+        free(io->completed);
+        free(io->threads);
+        free(io->reaped);
+        free(io);
+        return NULL;
+    }
+    cnd_init(&io->work);
+    cnd_init(&io->complete);
+
+    for (; io->thread_count < thread_count; io->thread_count++) if (thrd_create(
+        &io->threads[io->thread_count], worker, io
+    ) != thrd_success) break;
+    if (io->thread_count > 0) return io;
+
+    async_io_del(io);
+    return NULL;
+}
+
+bool async_io_uring(const async_io_t* io) {
+    return io->uring;
+}
+
+size_t async_io_submit(
+    async_io_t* io, io_request_t* const* requests, size_t count
+) {
+    if (count > io->depth - io->in_flight) count = io->depth - io->in_flight;
+    if (count == 0) return 0;
+
+    for (size_t i = 0; i < count; i++) requests[i]->done = false;
+    const size_t submitted = io->uring ?
+        uring_submit(&io->ring, requests, count) :
+        pool_submit(io, requests, count);
+    io->in_flight += submitted;
+    return submitted;
+}
+
+size_t async_io_poll(async_io_t* io, const bool wait) {
+    if (io->in_flight == 0) return 0;
+    const size_t count = io->uring ? uring_poll(io, wait) : pool_poll(io, wait);
+    io->in_flight -= count;
+    for (size_t i = 0; i < count; i++)
+        finish(io->reaped[i]);
+    return count;
+}
+
+void async_io_del(async_io_t* io) {
+    if (!io) return;
+    while (io->in_flight > 0) async_io_poll(io, true);
+
+    if (io->uring) uring_del(&io->ring);
+    else {
+        mtx_lock(&io->lock);
+        io->running = false;
+        cnd_broadcast(&io->work);
+        mtx_unlock(&io->lock);
+        for (size_t i = 0; i < io->thread_count; i++)
+            thrd_join(io->threads[i], NULL);
+        cnd_destroy(&io->complete);
+        cnd_destroy(&io->work);
+        mtx_destroy(&io->lock);
+    }
+    free(io->pending);
+    free(io->completed);
+    free(io->threads);
+    free(io->reaped);
+    free(io);
+}
@@ -0,0 +1,815 @@
+// Copyright (c) 2025 Lenny Siebert
+//
+// This software is dual-licensed:
+//
+// 1. Open Source License:
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License version 3
+//    as published by the Free Software Foundation.
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY. See the GNU General Public
+//    License for more details: https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// 2. Commercial License:
+//    A commercial license will be available at a later time for use in commercial products.
+
+#include "binary_log.h"
+#include "arena.h"
+#include "common.h"
+#include "timestamp.h"
+#include <threads.h>
+
+
+/**
+ * @brief Magic bytes at the start of every binary log.
+ */
+static const char magic[8] = { 'F', 'W', 'B', 'L', 'O', 'G', '0', '1' };
+
+/**
+ * @brief Types of records in a binary log.
+ *
+ * A format record defines the format string of an id,
+ * before any message record uses the id.
+ */
+enum record_type_e {
+    record_format = 'F',
+    record_message = 'M',
+    record_sequence = 'S'
+};
+
+/**
+ * @brief Marks a null string argument.
+ */
+#define NULL_STRING UINT32_MAX
+
+static const char* names[] = {
+    "CRITICAL", "ERROR", "WARNING", "STATUS", "INFO"
+};
+
+struct binary_log_s {
+    FILE* file;
+    mtx_t lock;
+    struct {
+        uint8_t* data;
+        size_t length;
+        size_t size;
+    } buffer;
+    struct {
+        struct format_slot_s {
+            uint64_t hash;
+            const char* text;
+            uint32_t id;
+        }* slots;
+        size_t capacity;
+        uint32_t count;
+        arena_t* texts;
+    } formats;
+};
+
+
+
+/**
+ * @brief A conversion specification of a format string.
+ *
+ * The size is the length modifier: 'H' for hh, 'h', 'l', 'q' for ll,
+ * 'j', 'z', 't', 'L' or zero if there is none.
+ */
+struct spec_s {
+    const char* start;
+    size_t length;
+    char conversion;
+    char size;
+    bool star_width;
+    bool star_precision;
+};
+
+/**
+ * @brief Finds the next conversion specification in a format string.
+ *
+ * Escaped percent signs are skipped.
+ * Returns false if there is no further specification.
+ */
+static bool next_spec(const char* cursor, struct spec_s* spec) {
+    while ((cursor = strchr(cursor, '%'))) {
+        if (cursor[1] == '%') {
+            cursor += 2;
+            continue;
+        }
+
+        *spec = (struct spec_s) { .start = cursor };
+        const char* c = cursor + 1;
+        while (*c && strchr("-+ #0'", *c)) c++;
+
+        if (*c == '*') {
+            spec->star_width = true;
+            c++;
+        }
+        else while (isdigit((unsigned char)*c)) c++;
+
+        if (*c == '.') {
+            c++;
+            if (*c == '*') {
+                spec->star_precision = true;
+                c++;
+            }
+            else while (isdigit((unsigned char)*c)) c++;
+        }
+
+        if (c[0] == 'h' && c[1] == 'h') {
+            spec->size = 'H';
+            c += 2;
+        }
+        else if (c[0] == 'l' && c[1] == 'l') {
+            spec->size = 'q';
+            c += 2;
+        }
+        else if (*c && strchr("hljztL", *c)) spec->size = *c++;
+
+        if (!*c) return false;
+        spec->conversion = *c;
+        spec->length = c - cursor + 1;
+        return true;
+    }
+    return false;
+}
+
+
+
+static bool put(binary_log_t* binary, const void* data, const size_t size) {
+    if (binary->buffer.length + size > binary->buffer.size) {
+        size_t new_size = binary->buffer.size ? binary->buffer.size : 256;
+        while (new_size < binary->buffer.length + size) new_size <<= 1;
+
+        uint8_t* new_data = realloc(binary->buffer.data, new_size);
+        if (!new_data) {
+            perror("Failed to grow the binary log buffer");
+            return false;
+        }
+        binary->buffer.data = new_data;
+        binary->buffer.size = new_size;
+    }
+    memcpy(binary->buffer.data + binary->buffer.length, data, size);
+    binary->buffer.length += size;
+    return true;
+}
+
+static bool put_string(binary_log_t* binary, const char* string) {
+    if (!string) {
+        const uint32_t length = NULL_STRING;
+        return put(binary, &length, sizeof(length));
+    }
+    const uint32_t length = strlen(string);
+    return put(binary, &length, sizeof(length)) &&
+        put(binary, string, length);
+}
+
+static bool put_record(
+    binary_log_t* binary, const enum record_type_e type,
+    const logger_significance_t sign, const uint64_t stamp
+) {
+    const uint8_t type_byte = type;
+    const uint8_t sign_byte = sign;
+    return put(binary, &type_byte, 1) &&
+        put(binary, &sign_byte, 1) &&
+        put(binary, &stamp, sizeof(stamp));
+}
+
+/**
+ * @brief Gets the id of a format string and records its definition if it is new.
+ *
+ * Format strings are looked up by their content, so a format that is
+ * built in a buffer never gets the id of a string that was there before.
+ * The table keeps its own copy of every format.
+ */
+static bool format_id(
+    binary_log_t* binary, const char* format, uint32_t* id
+) {
+    if ((binary->formats.count + 1) * 2 > binary->formats.capacity) {
+        const size_t capacity = binary->formats.capacity ?
+            binary->formats.capacity * 2 : 64;
+        struct format_slot_s* slots = calloc(capacity, sizeof(struct format_slot_s));
+        if (!binary->formats.texts) binary->formats.texts = arena_create(4096);
+        if (!slots || !binary->formats.texts) {
+            perror("Failed to grow the format table of the binary log");
+            free(slots);
+            return false;
+        }
+
+        for (size_t i = 0; i < binary->formats.capacity; i++) {
+            const struct format_slot_s* old = &binary->formats.slots[i];
+            if (!old->text) continue;
+            size_t slot = old->hash & (capacity - 1);
+            while (slots[slot].text) slot = (slot + 1) & (capacity - 1);
+            slots[slot] = *old;
+        }
+
+        free(binary->formats.slots);
+        binary->formats.slots = slots;
+        binary->formats.capacity = capacity;
+    }
+
+    uint64_t hash = 14695981039346656037ULL;
+    size_t length = 0;
+    for (; format[length]; length++) {
+        hash ^= (unsigned char)format[length];
+        hash *= 1099511628211ULL;
+    }
+
+    const size_t mask = binary->formats.capacity - 1;
+    size_t slot = hash & mask;
+    for (; binary->formats.slots[slot].text; slot = (slot + 1) & mask) {
+        const struct format_slot_s* found = &binary->formats.slots[slot];
+        if (found->hash == hash && strcmp(found->text, format) == 0) {
+            *id = found->id;
+            return true;
+        }
+    }
+
+    const char* text = arena_strndup(binary->formats.texts, format, length);
+    if (!text) {
+        perror("Failed to copy a format of the binary log");
+        return false;
+    }
+    *id = binary->formats.count++;
+    binary->formats.slots[slot] = (struct format_slot_s) {
+        .hash = hash, .text = text, .id = *id
+    };
+
+    const uint8_t type = record_format;
+    return put(binary, &type, 1) &&
+        put(binary, id, sizeof(*id)) &&
+        put_string(binary, format);
+}
+
+/**
+ * @brief Appends the raw bytes of the arguments of a format string.
+ *
+ * Integers are widened to 64 bit, floating point values to double,
+ * strings are copied with their length and written back counts are skipped.
+ */
+static bool put_args(
+    binary_log_t* binary, const char* format, va_list args
+) {
+    struct spec_s spec;
+    const char* cursor = format;
+    while (next_spec(cursor, &spec)) {
+        cursor = spec.start + spec.length;
+
+        if (spec.star_width) {
+            const int64_t width = va_arg(args, int);
+            if (!put(binary, &width, sizeof(width))) return false;
+        }
+        if (spec.star_precision) {
+            const int64_t precision = va_arg(args, int);
+            if (!put(binary, &precision, sizeof(precision))) return false;
+        }
+
+        bool result = true;
+        switch (spec.conversion) {
+            case 'd':
+            case 'i': {
+                int64_t value;
+                switch (spec.size) {
+                    case 'l': value = va_arg(args, long); break;
+                    case 'q': value = va_arg(args, long long); break;
+                    case 'j': value = va_arg(args, intmax_t); break;
+                    case 'z': value = va_arg(args, size_t); break;
+                    case 't': value = va_arg(args, ptrdiff_t); break;
+                    default: value = va_arg(args, int); break;
+                }
+                result = put(binary, &value, sizeof(value));
+                break;
+            }
+            case 'o':
+            case 'u':
+            case 'x':
+            case 'X': {
+                uint64_t value;
+                switch (spec.size) {
+                    case 'l': value = va_arg(args, unsigned long); break;
+                    case 'q': value = va_arg(args, unsigned long long); break;
+                    case 'j': value = va_arg(args, uintmax_t); break;
+                    case 'z': value = va_arg(args, size_t); break;
+                    case 't': value = va_arg(args, ptrdiff_t); break;
+                    case 'H': value = (unsigned char)va_arg(args, unsigned); break;
+                    case 'h': value = (unsigned short)va_arg(args, unsigned); break;
+                    default: value = va_arg(args, unsigned); break;
+                }
+                result = put(binary, &value, sizeof(value));
+                break;
+            }
+            case 'c': {
+                const int64_t value = va_arg(args, int);
+                result = put(binary, &value, sizeof(value));
+                break;
+            }
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A': {
+                const double value = spec.size == 'L' ?
+                    (double)va_arg(args, long double) : va_arg(args, double);
+                result = put(binary, &value, sizeof(value));
+                break;
+            }
+            case 's':
+                result = put_string(binary, va_arg(args, const char*));
+                break;
+            case 'p': {
+                const uint64_t value = (uintptr_t)va_arg(args, void*);
+                result = put(binary, &value, sizeof(value));
+                break;
+            }
+            case 'n':
+                va_arg(args, void*);
+                break;
+            default:
+                break;
+        }
+        if (!result) return false;
+    }
+    return true;
+}
+
+static bool write_buffer(binary_log_t* binary) {
+    const size_t length = binary->buffer.length;
+    binary->buffer.length = 0;
+    return fwrite(
+        binary->buffer.data, 1, length, binary->file
+    ) == length;
+}
+
+
+
+bool logger_mk_binary(logger_t* logger, FILE* file) {
+    if (logger->binary) return true;
+
+    binary_log_t* binary = calloc(1, sizeof(binary_log_t));
+    if (!binary) {
+        perror("Failed to create binary log");
+        return false;
+    }
+    binary->file = file;
+    if (mtx_init(&binary->lock, mtx_plain) != thrd_success) {
+        free(binary);
+        return false;
+    }
+
+    struct timespec wall;
+    timespec_get(&wall, TIME_UTC);
+    const uint64_t mono = timestamp_mono();
+    const int64_t wall_second = wall.tv_sec;
+    const uint32_t wall_nanosecond = wall.tv_nsec;
+
+    const bool result = put(binary, magic, sizeof(magic)) &&
+        put(binary, &mono, sizeof(mono)) &&
+        put(binary, &wall_second, sizeof(wall_second)) &&
+        put(binary, &wall_nanosecond, sizeof(wall_nanosecond)) &&
+        put_string(binary, logger->name) &&
+        write_buffer(binary);
+
+    if (!result) {
+        binary_log_del(binary);
+        return logger_log(logger, error,
+            "Binary log of logger %s cannot be written.", logger->name
+        );
+    }
+
+    logger->binary = binary;
+    return true;
+}
+
+bool binary_log_write(
+    binary_log_t* binary, const logger_significance_t sign,
+    const uint64_t stamp, const char* format, va_list args
+) {
+    mtx_lock(&binary->lock);
+    uint32_t id;
+    bool result = format_id(binary, format, &id) &&
+        put_record(binary, record_message, sign, stamp) &&
+        put(binary, &id, sizeof(id));
+
+    const size_t length_offset = binary->buffer.length;
+    uint32_t length = 0;
+    result = result &&
+        put(binary, &length, sizeof(length)) &&
+        put_args(binary, format, args);
+
+    if (result) {
+        length = binary->buffer.length - length_offset - sizeof(length);
+        memcpy(
+            binary->buffer.data + length_offset, &length, sizeof(length)
+        );
+        result = write_buffer(binary);
+    }
+    else binary->buffer.length = 0;
+
+    mtx_unlock(&binary->lock);
+    return result;
+}
+
+bool binary_log_write_sequence(
+    binary_log_t* binary, const logger_significance_t sign,
+    const uint64_t stamp, char** messages, const size_t message_count
+) {
+    mtx_lock(&binary->lock);
+    const uint32_t count = message_count;
+    bool result = put_record(binary, record_sequence, sign, stamp) &&
+        put(binary, &count, sizeof(count));
+
+    for (size_t i = 0; result && i < message_count; i++)
+        result = put_string(binary, messages[i]);
+
+    if (result) result = write_buffer(binary);
+    else binary->buffer.length = 0;
+
+    mtx_unlock(&binary->lock);
+    return result;
+}
+
+bool binary_log_write_batch(
+    binary_log_t* binary, const logger_significance_t sign,
+    const uint64_t stamp, const char* const* messages,
+    const size_t message_count
+) {
+    static const char* const plain = "%s";
+
+    mtx_lock(&binary->lock);
+    uint32_t id;
+    bool result = format_id(binary, plain, &id);
+    for (size_t i = 0; result && i < message_count; i++) {
+        const uint32_t length = messages[i] ?
+            sizeof(uint32_t) + strlen(messages[i]) : sizeof(uint32_t);
+        result = put_record(binary, record_message, sign, stamp) &&
+            put(binary, &id, sizeof(id)) &&
+            put(binary, &length, sizeof(length)) &&
+            put_string(binary, messages[i]);
+    }
+
+    if (result) result = write_buffer(binary);
+    else binary->buffer.length = 0;
+
+    mtx_unlock(&binary->lock);
+    return result;
+}
+
+void binary_log_del(binary_log_t* binary) {
+    if (!binary) return;
+    fflush(binary->file);
+    mtx_destroy(&binary->lock);
+    free(binary->buffer.data);
+    free(binary->formats.slots);
+    arena_del(binary->formats.texts);
+    free(binary);
+}
+
+
+
+/**
+ * @brief Reading state of the decoder.
+ *
+ * The records are read from a view of the binary log, up to its end.
+ * Format strings are stored by their id.
+ * The anchor maps monotonic stamps to the wall-clock time.
+ */
+struct decoder_s {
+    const char* cursor;
+    const char* end;
+    FILE* out;
+    char* name;
+    char** formats;
+    uint32_t format_count;
+    uint64_t anchor_mono;
+    int64_t anchor_wall_second;
+    uint32_t anchor_wall_nanosecond;
+};
+
+static bool take(
+    struct decoder_s* decoder, void* buffer, const size_t size
+) {
+    if ((size_t)(decoder->end - decoder->cursor) < size) return false;
+    memcpy(buffer, decoder->cursor, size);
+    decoder->cursor += size;
+    return true;
+}
+
+/**
+ * @brief Takes a string without copying it, it is not terminated.
+ */
+static bool take_span(
+    struct decoder_s* decoder, const char** span, uint32_t* length
+) {
+    if (!take(decoder, length, sizeof(*length))) return false;
+    if (*length == NULL_STRING) {
+        *span = "(null)";
+        *length = 6;
+        return true;
+    }
+    if ((size_t)(decoder->end - decoder->cursor) < *length) return false;
+    *span = decoder->cursor;
+    decoder->cursor += *length;
+    return true;
+}
+
+static char* take_string(struct decoder_s* decoder) {
+    const char* span;
+    uint32_t length;
+    if (!take_span(decoder, &span, &length)) return NULL;
+
+    char* string = malloc((size_t)length + 1);
+    if (!string) return NULL;
+    memcpy(string, span, length);
+    string[length] = '\0';
+    return string;
+}
+
+/**
+ * @brief Writes the meta and significance of a line, just like the logger does.
+ */
+static bool decode_header(
+    const struct decoder_s* decoder, const uint8_t sign,
+    const uint64_t stamp, const char* opening
+) {
+    if (sign >= sizeof(names) / sizeof(names[0])) return false;
+
+    const int64_t elapsed = (int64_t)(stamp - decoder->anchor_mono);
+    const int64_t nanoseconds =
+        decoder->anchor_wall_nanosecond + elapsed % 1000000000LL;
+    const time_t second = decoder->anchor_wall_second +
+        elapsed / 1000000000LL + (nanoseconds >= 1000000000LL) -
+        (nanoseconds < 0);
+
+    struct tm local;
+    if (!timestamp_local(second, &local)) return false;
+
+    return fprintf(
+        decoder->out,
+        "(%02d:%02d:%02d, %02d-%02d-%d, %llu.%09llu, %s)  %s  %s",
+        local.tm_hour, local.tm_min, local.tm_sec,
+        local.tm_mday, local.tm_mon + 1, local.tm_year + 1900,
+        (unsigned long long)(stamp / 1000000000ULL),
+        (unsigned long long)(stamp % 1000000000ULL),
+        decoder->name, names[sign], opening
+    ) >= 0;
+}
+
+/**
+ * @brief Reads a value of the argument bytes and advances the cursor.
+ */
+static bool arg(
+    const uint8_t** cursor, const uint8_t* end, void* value, const size_t size
+) {
+    if ((size_t)(end - *cursor) < size) return false;
+    memcpy(value, *cursor, size);
+    *cursor += size;
+    return true;
+}
+
+/**
+ * @brief Formats a single conversion specification with its recorded argument.
+ *
+ * The specification is rebuilt without its length modifier,
+ * because all recorded integers are 64 bit wide.
+ */
+static bool decode_spec(
+    FILE* out, const struct spec_s* spec,
+    const uint8_t** cursor, const uint8_t* end
+) {
+    char format[64];
+    size_t length = 0;
+    for (size_t i = 0; i < spec->length - 1 && length < 56; i++) {
+        const char c = spec->start[i];
+        if (strchr("hljztL", c) && i > 0) continue;
+        format[length++] = c;
+    }
+
+    int64_t stars[2] = { 0 };
+    int star_count = 0;
+    if (spec->star_width &&
+        !arg(cursor, end, &stars[star_count++], sizeof(int64_t))
+    ) return false;
+    if (spec->star_precision &&
+        !arg(cursor, end, &stars[star_count++], sizeof(int64_t))
+    ) return false;
+
+    #define DECODE_PRINT(value) ( \
+        star_count == 0 ? fprintf(out, format, value) : \
+        star_count == 1 ? fprintf(out, format, (int)stars[0], value) : \
+        fprintf(out, format, (int)stars[0], (int)stars[1], value))
+
+    switch (spec->conversion) {
+        case 'd':
+        case 'i':
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X': {
+            uint64_t value;
+            if (!arg(cursor, end, &value, sizeof(value))) return false;
+            format[length++] = 'l';
+            format[length++] = 'l';
+            format[length++] = spec->conversion;
+            format[length] = '\0';
+            if (strchr("di", spec->conversion))
+                return DECODE_PRINT((long long)value) >= 0;
+            return DECODE_PRINT((unsigned long long)value) >= 0;
+        }
+        case 'c': {
+            int64_t value;
+            if (!arg(cursor, end, &value, sizeof(value))) return false;
+            format[length++] = 'c';
+            format[length] = '\0';
+            return DECODE_PRINT((int)value) >= 0;
+        }
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A': {
+            double value;
+            if (!arg(cursor, end, &value, sizeof(value))) return false;
+            format[length++] = spec->conversion;
+            format[length] = '\0';
+            return DECODE_PRINT(value) >= 0;
+        }
+        case 's': {
+            uint32_t string_length;
+            if (!arg(cursor, end, &string_length, sizeof(string_length)))
+                return false;
+
+            const char* string = "(null)";
+            size_t available = 6;
+            if (string_length != NULL_STRING) {
+                if ((size_t)(end - *cursor) < string_length) return false;
+                string = (const char*)*cursor;
+                available = string_length;
+                *cursor += string_length;
+            }
+
+            // The string is printed from the view, where it is not terminated,
+            // so its length is the precision, unless the format asks for less.
+            int precision = available > INT_MAX ? INT_MAX : (int)available;
+            format[length] = '\0';
+            const char* dot = memchr(format, '.', length);
+            if (dot) {
+                const int asked = spec->star_precision ?
+                    (int)stars[--star_count] : atoi(dot + 1);
+                if (asked >= 0 && asked < precision) precision = asked;
+                length = dot - format;
+            }
+            memcpy(format + length, ".*s", 4);
+            return (star_count ?
+                fprintf(out, format, (int)stars[0], precision, string) :
+                fprintf(out, format, precision, string)) >= 0;
+        }
+        case 'p': {
+            uint64_t value;
+            if (!arg(cursor, end, &value, sizeof(value))) return false;
+            format[length++] = 'p';
+            format[length] = '\0';
+            return DECODE_PRINT((void*)(uintptr_t)value) >= 0;
+        }
+        default:
+            return true;
+    }
+    #undef DECODE_PRINT
+}
+
+static bool decode_message(struct decoder_s* decoder) {
+    uint8_t sign;
+    uint64_t stamp;
+    uint32_t id, length;
+    if (!take(decoder, &sign, 1) ||
+        !take(decoder, &stamp, sizeof(stamp)) ||
+        !take(decoder, &id, sizeof(id)) ||
+        !take(decoder, &length, sizeof(length))
+    ) return false;
+    if (id >= decoder->format_count || !decoder->formats[id]) return false;
+    if ((size_t)(decoder->end - decoder->cursor) < length) return false;
+
+    const uint8_t* args = (const uint8_t*)decoder->cursor;
+    decoder->cursor += length;
+
+    bool result = decode_header(decoder, sign, stamp, "");
+    const uint8_t* cursor = args;
+    const char* text = decoder->formats[id];
+    struct spec_s spec;
+    while (result) {
+        const bool found = next_spec(text, &spec);
+        const char* literal_end = found ? spec.start : text + strlen(text);
+        for (const char* c = text; c < literal_end; c++) {
+            fputc(*c, decoder->out);
+            if (c[0] == '%' && c[1] == '%') c++;
+        }
+        if (!found) break;
+
+        result = decode_spec(decoder->out, &spec, &cursor, args + length);
+        text = spec.start + spec.length;
+    }
+    fputc('\n', decoder->out);
+    return result;
+}
+
+static bool decode_sequence(struct decoder_s* decoder) {
+    uint8_t sign;
+    uint64_t stamp;
+    uint32_t count;
+    if (!take(decoder, &sign, 1) ||
+        !take(decoder, &stamp, sizeof(stamp)) ||
+        !take(decoder, &count, sizeof(count))
+    ) return false;
+
+    if (!decode_header(decoder, sign, stamp, "[\n")) return false;
+    for (uint32_t i = 0; i < count; i++) {
+        const char* message;
+        uint32_t length;
+        if (!take_span(decoder, &message, &length)) return false;
+        fprintf(decoder->out, "     %.*s\n", (int)length, message);
+    }
+    fputs("]\n", decoder->out);
+    return true;
+}
+
+static bool decode_format(struct decoder_s* decoder) {
+    uint32_t id;
+    if (!take(decoder, &id, sizeof(id))) return false;
+    char* format = take_string(decoder);
+    if (!format) return false;
+
+    if (id >= decoder->format_count) {
+        const uint32_t count = id + 1 > decoder->format_count * 2 ?
+            id + 1 : decoder->format_count * 2;
+        char** formats = realloc(decoder->formats, count * sizeof(char*));
+        if (!formats) {
+            free(format);
+            return false;
+        }
+        for (uint32_t i = decoder->format_count; i < count; i++)
+            formats[i] = NULL;
+        decoder->formats = formats;
+        decoder->format_count = count;
+    }
+
+    free(decoder->formats[id]);
+    decoder->formats[id] = format;
+    return true;
+}
+
+bool binary_log_decode(const char* binary_path, FILE* text_file) {
+    file_view_t view;
+    if (!fview(&view, binary_path)) {
+        perror("Binary log cannot be read");
+        return false;
+    }
+
+    char file_magic[sizeof(magic)];
+    struct decoder_s decoder = {
+        .cursor = view.data,
+        .end = view.data + view.size,
+        .out = text_file
+    };
+
+    if (!take(&decoder, file_magic, sizeof(file_magic)) ||
+        memcmp(file_magic, magic, sizeof(magic)) != 0
+    ) {
+        fprintf(stderr, "File is not a binary log.\n");
+        fview_release(&view);
+        return false;
+    }
+
+    if (!take(&decoder, &decoder.anchor_mono, sizeof(uint64_t)) ||
+        !take(&decoder, &decoder.anchor_wall_second, sizeof(int64_t)) ||
+        !take(&decoder, &decoder.anchor_wall_nanosecond, sizeof(uint32_t)) ||
+        !(decoder.name = take_string(&decoder))
+    ) {
+        fprintf(stderr, "Header of the binary log is incomplete.\n");
+        fview_release(&view);
+        return false;
+    }
+
+    bool result = true;
+    uint8_t type;
+    while (result && take(&decoder, &type, 1)) {
+        switch (type) {
+            case record_format: result = decode_format(&decoder); break;
+            case record_message: result = decode_message(&decoder); break;
+            case record_sequence: result = decode_sequence(&decoder); break;
+            default: result = false; break;
+        }
+    }
+    if (!result) fprintf(stderr, "Binary log contains an invalid record.\n");
+
+    for (uint32_t i = 0; i < decoder.format_count; i++)
+        free(decoder.formats[i]);
+    free(decoder.formats);
+    free(decoder.name);
+    fview_release(&view);
+    return result;
+}
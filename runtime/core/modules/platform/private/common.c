@@ -15,33 +15,26 @@
 // 2. Commercial License:
 //    A commercial license will be available at a later time for use in commercial products.
 
-char* str_to_lower(const char* string)
-{
-    char* temp = strdup(string);
-    for (char* cur = temp; *cur; ++cur) *cur = tolower(*cur);
-    return temp;
+#include "common.h"
+#include "info.h"
+#include "path.h"
+#include "str.h"
+#include <stdatomic.h>
+
+char* str_to_lower(const char* string) {
+    const size_t size = strlen(string) + 1;
+    char* lower = malloc(size);
+    if (lower) str_lower(lower, size, string);
+    return lower;
 }
 
 bool superior_path(char* buffer, const char* path) {
-    bool terminated = false;
-    size_t i = strlen(path) + 1;
-    while (i > 0) {
-        i--;
-        buffer[i] = path[i];
+    const char* separator = str_last_separator(path, strlen(path));
+    if (!separator) return false;
 
-        if (terminated) {
-            continue;
-        }
-
-        if (buffer[i] == '\\' || buffer[i] == '/') {
-            buffer[i] = '\0';
-            terminated = true;
-        }
-
-        if (i == 1) {
-            return false;
-        }
-    }
+    const size_t length = separator - path;
+    memmove(buffer, path, length);
+    buffer[length] = '\0';
     return true;
 }
 
@@ -56,110 +49,187 @@ bool fcontent(
     }
 
     const int result = fseek(file, 0, SEEK_SET);
-    if (result != 0) {
+    if (result != 0 || buffer_size == 0) {
         perror("File cannot be read");
         return false;
     }
 
-    char read;
-    size_t i = 0;
-    while ((read = fgetc(file)) != EOF) {
-        if (i >= buffer_size) break;
-        buffer[i] = read;
-        i++;
-    }
-    buffer[i] = '\0';
-
-    return true;
+    const size_t size = fread(buffer, 1, buffer_size - 1, file);
+    buffer[size] = '\0';
+    return !ferror(file);
 }
 
-bool fcopy(
-    FILE* source_file, const char* destination_path
-) {
-    FILE* target_file = fopen(destination_path, "w");
-    if (!target_file) {
-        return false;
-    }
-
-    const int result = fseek(source_file, 0, SEEK_SET);
+/**
+ * @brief Size of the chunks fcopy() copies if the kernel cannot copy the file.
+ */
+#define FCOPY_CHUNK_SIZE (1 << 20)
+
+/**
+ * @brief Reads the whole file into a new buffer, starting with a single bulk read of its size.
+ *
+ * Pipes and files of procfs or sysfs report no size, so the buffer
+ * grows until the end of the file is read. It has room for a byte more
+ * than the size, so the end of a regular file is found without growing.
+ * The buffer is terminated by a zero byte behind the content.
+ */
+static bool fview_read(file_view_t* view, FILE* file, const size_t size) {
+    size_t capacity = size > 0 ? size + 2 : 4096;
+    char* data = malloc(capacity);
+    if (!data) return false;
+
+    size_t length = 0;
+    while (true) {
+        length += fread(data + length, 1, capacity - 1 - length, file);
+        if (ferror(file)) {
+            free(data);
+            return false;
+        }
+        if (length < capacity - 1) break;
 
-    if (result != 0) {
-        return false;
-    }
-    char read;
-    while ((read = fgetc(source_file)) != EOF) {
-        fputc(read, target_file);
+        char* grown = realloc(data, capacity * 2);
+        if (!grown) {
+            free(data);
+            return false;
+        }
+        data = grown;
+        capacity *= 2;
     }
-
-    fclose(target_file);
+    data[length] = '\0';
+    *view = (file_view_t) { .data = data, .size = length, .mapped = false };
     return true;
 }
 
-void str_replace(char* target, const char* needle, const char* replacement)
-{
-    char buffer[1024] = { 0 };
-    char *insert_point = &buffer[0];
-    const char *tmp = target;
-    const size_t needle_len = strlen(needle);
-    const size_t repl_len = strlen(replacement);
-
-    while (1) {
-        const char* p = strstr(tmp, needle);
-
-        if (p == NULL) {
-            strcpy(insert_point, tmp);
-            break;
-        }
-
-        memcpy(insert_point, tmp, p - tmp);
-        insert_point += p - tmp;
-
-        memcpy(insert_point, replacement, repl_len);
-        insert_point += repl_len;
-
-        tmp = p + needle_len;
-    }
-    strcpy(target, buffer);
+bool exe_dir(char* buffer, const size_t buffer_size) {
+    const char* dir = info_dir(location_executable);
+    return dir && (size_t)snprintf(buffer, buffer_size, "%s", dir) < buffer_size;
 }
 
 
 
-
 #ifdef _WIN32
 #include <direct.h>
+#include <fcntl.h>
 #include <io.h>
+#include <sys/stat.h>
 #include <windows.h>
 
 bool work_dir(char* buffer, const size_t buffer_size) {
     return _getcwd(buffer, buffer_size);
 }
 
-bool exe_dir(char* buffer, const size_t buffer_size) {
+static unsigned long process_id(void) {
+    return GetCurrentProcessId();
+}
 
-    char path[MAX_PATH];
+static bool atomic_stage(const file_write_t* content, const char* temp_path) {
+    const int file = _open(
+        temp_path, _O_WRONLY | _O_CREAT | _O_EXCL | _O_BINARY,
+        _S_IREAD | _S_IWRITE
+    );
+    if (file < 0) return false;
+
+    bool result = true;
+    for (size_t done = 0; result && done < content->size;) {
+        const size_t rest = content->size - done;
+        const int written = _write(
+            file, (const char*)content->data + done,
+            rest > INT_MAX ? INT_MAX : (unsigned int)rest
+        );
+        result = written > 0;
+        if (result) done += written;
+    }
+    result = _commit(file) == 0 && result;
+    return _close(file) == 0 && result;
+}
 
-    const auto str_len = GetModuleFileName(
-        NULL,
-        path,
-        MAX_PATH
+static bool atomic_replace(const char* temp_path, const char* path) {
+    return MoveFileEx(
+        temp_path, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH
     );
+}
 
-    if (str_len == 0) {
+// The rename is written through, there is no directory to sync.
+static bool dir_sync(const char* path) {
+    return true;
+}
+
+
+bool fwrite_vectored(
+    FILE* file, const io_vector_t* vectors, const size_t count
+) {
+    _lock_file(file);
+    bool result = true;
+    for (size_t i = 0; i < count && result; i++) result = _fwrite_nolock(
+        vectors[i].data, 1, vectors[i].size, file
+    ) == vectors[i].size;
+    _unlock_file(file);
+    return result;
+}
+
+bool fcopy(
+    FILE* source_file, const char* destination_path, uint64_t* copied
+) {
+    uint64_t total = 0;
+    if (copied) *copied = 0;
+    FILE* target_file = fopen(destination_path, "wb");
+    if (!target_file) return false;
+
+    const long long position = _ftelli64(source_file);
+    char* chunk = malloc(FCOPY_CHUNK_SIZE);
+    bool result = chunk && _fseeki64(source_file, 0, SEEK_SET) == 0;
+    while (result) {
+        const size_t read = fread(chunk, 1, FCOPY_CHUNK_SIZE, source_file);
+        if (read == 0) {
+            result = !ferror(source_file);
+            break;
+        }
+        result = fwrite(chunk, 1, read, target_file) == read;
+        if (result) total += read;
+    }
+
+    free(chunk);
+    if (position >= 0) _fseeki64(source_file, position, SEEK_SET);
+    result = fclose(target_file) == 0 && result;
+    if (copied) *copied = total;
+    return result;
+}
+
+bool fview(file_view_t* view, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    const long long size = _filelengthi64(_fileno(file));
+    if (size < 0) {
+        fclose(file);
         return false;
     }
 
-    for (size_t i = str_len; i > 0; i--) {
-        if (
-            path[i] == '\\' ||
-            path[i] == '/'
-        ) {
-            path[i] = '\0';
-            break;
+    if (size > 0) {
+        const HANDLE mapping = CreateFileMapping(
+            (HANDLE)_get_osfhandle(_fileno(file)),
+            NULL, PAGE_READONLY, 0, 0, NULL
+        );
+        const char* data = mapping ?
+            MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+        if (mapping) CloseHandle(mapping);
+        if (data) {
+            fclose(file);
+            *view = (file_view_t) {
+                .data = data, .size = size, .mapped = true
+            };
+            return true;
         }
     }
-    strcpy_s(buffer, buffer_size, path);
 
-    return true;
+    const bool result = fview_read(view, file, size);
+    fclose(file);
+    return result;
+}
+
+void fview_release(file_view_t* view) {
+    if (view->mapped) UnmapViewOfFile(view->data);
+    else free((char*)view->data);
+    *view = (file_view_t) { 0 };
 }
 
 bool can_access(const char* path) {
@@ -176,10 +246,10 @@ int list_files(const char* dir_path, char*** buffer) {
     auto found_file = INVALID_HANDLE_VALUE;
     int total_count = 0;
 
-    char search_path[MAX_PATH];
-    snprintf(search_path, MAX_PATH, "%s\\*", dir_path);
-
-    found_file = FindFirstFile(search_path, &found_file_data);
+    path_t search_path = { 0 };
+    if (path_set(&search_path, dir_path) && path_join(&search_path, "*"))
+        found_file = FindFirstFile(path_str(&search_path), &found_file_data);
+    path_release(&search_path);
     if (found_file == INVALID_HANDLE_VALUE) {
         return 0;
     }
@@ -226,28 +296,238 @@ int list_files(const char* dir_path, char*** buffer) {
 #else
 
 #include <dirent.h>
-#include <libgen.h>
+#include <errno.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/sendfile.h>
+#endif
 
 bool work_dir(char* buffer, const size_t buffer_size) {
-     return getcwd(buffer, buffer_size) == 0;
+    return getcwd(buffer, buffer_size) != NULL;
 }
 
-bool exe_dir(char* buffer, const size_t buffer_size) {
-    const size_t path_len = readlink(
-        "/proc/self/exe",
-        buffer,
-        buffer_size - 1
+static unsigned long process_id(void) {
+    return getpid();
+}
+
+/**
+ * @brief Writes the data of a file to the disk.
+ *
+ * On macOS fsync only hands it to the drive, which can still lose it.
+ */
+static bool file_sync(const int fd) {
+#ifdef __APPLE__
+    return fcntl(fd, F_FULLFSYNC) == 0 || fsync(fd) == 0;
+#else
+    return fdatasync(fd) == 0;
+#endif
+}
+
+/**
+ * @brief Writes the content into a new temporary file.
+ *
+ * The temporary file gets the permissions of the file it replaces,
+ * so replacing a file keeps its permissions.
+ */
+static bool atomic_stage(const file_write_t* content, const char* temp_path) {
+    const int fd = open(
+        temp_path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666
     );
+    if (fd < 0) return false;
+
+    struct stat target;
+    bool result = stat(content->path, &target) != 0 ||
+        fchmod(fd, target.st_mode & 07777) == 0;
+    for (size_t done = 0; result && done < content->size;) {
+        const ssize_t written = write(
+            fd, (const char*)content->data + done, content->size - done
+        );
+        if (written < 0 && errno == EINTR) continue;
+        result = written > 0;
+        if (result) done += written;
+    }
+    result = file_sync(fd) && result;
+    return close(fd) == 0 && result;
+}
+
+static bool atomic_replace(const char* temp_path, const char* path) {
+    return rename(temp_path, path) == 0;
+}
+
+static bool dir_sync(const char* path) {
+    const int fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return false;
+    const bool result = fsync(fd) == 0;
+    return close(fd) == 0 && result;
+}
+
+bool fwrite_vectored(
+    FILE* file, const io_vector_t* vectors, const size_t count
+) {
+    flockfile(file);
+    bool result = fflush(file) == 0;
+    const int fd = fileno(file);
+
+    struct iovec chunk[64];
+    size_t i = 0, skip = 0;
+    while (result && i < count) {
+        int chunk_count = 0;
+        for (size_t j = i; j < count && chunk_count < 64; j++) {
+            const size_t offset = j == i ? skip : 0;
+            chunk[chunk_count++] = (struct iovec) {
+                .iov_base = (char*)vectors[j].data + offset,
+                .iov_len = vectors[j].size - offset
+            };
+        }
+
+        ssize_t written = writev(fd, chunk, chunk_count);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            result = false;
+            break;
+        }
+
+        while (i < count && (size_t)written >= vectors[i].size - skip) {
+            written -= vectors[i].size - skip;
+            skip = 0;
+            i++;
+        }
+        skip += written;
+    }
+    funlockfile(file);
+    return result;
+}
 
-    if (path_len != (long unsigned int)-1) {
-        buffer[path_len] = '\0';
-        const char* dir = dirname(buffer);
-        strncpy(buffer, dir, buffer_size);
+/**
+ * @brief Lets the kernel copy the rest of the file behind the offset.
+ *
+ * Tries a reflink of the whole file first, then copy_file_range,
+ * that works across file systems since Linux 5.19, and sendfile.
+ * Returns false if none of them is supported for the files,
+ * the offset stays at the first byte that was not copied.
+ */
+static bool fcopy_kernel(
+    const int source, const int target, const uint64_t size, off_t* offset
+) {
+#ifdef __linux__
+    if (*offset == 0 && ioctl(target, FICLONE, source) == 0) {
+        *offset = size;
         return true;
     }
+
+    while ((uint64_t)*offset < size) {
+        const ssize_t copied = copy_file_range(
+            source, offset, target, NULL, size - *offset, 0
+        );
+        if (copied > 0) continue;
+        if (copied == 0) return true;
+        if (errno == EINTR) continue;
+        break;
+    }
+    if ((uint64_t)*offset >= size) return true;
+
+    while ((uint64_t)*offset < size) {
+        const ssize_t copied = sendfile(
+            target, source, offset, size - *offset
+        );
+        if (copied > 0) continue;
+        if (copied == 0) return true;
+        if (errno == EINTR) continue;
+        return false;
+    }
+    return true;
+#else
     return false;
+#endif
+}
+
+bool fcopy(
+    FILE* source_file, const char* destination_path, uint64_t* copied
+) {
+    if (copied) *copied = 0;
+    const int source = fileno(source_file);
+    struct stat attributes;
+    if (fstat(source, &attributes) != 0) return false;
+
+    const int target = open(
+        destination_path, O_WRONLY | O_CREAT | O_TRUNC, 0644
+    );
+    if (target < 0) return false;
+
+    off_t offset = 0;
+    bool result = S_ISREG(attributes.st_mode) &&
+        fcopy_kernel(source, target, attributes.st_size, &offset);
+
+    // Whatever the kernel could not copy is copied in large aligned chunks.
+    if (!result) {
+        char* chunk = aligned_alloc(4096, FCOPY_CHUNK_SIZE);
+        result = chunk != NULL;
+        while (result) {
+            ssize_t read = pread(source, chunk, FCOPY_CHUNK_SIZE, offset);
+            if (read < 0 && errno == EINTR) continue;
+            if (read <= 0) {
+                result = read == 0;
+                break;
+            }
+
+            for (ssize_t done = 0; done < read;) {
+                const ssize_t written = write(target, chunk + done, read - done);
+                if (written < 0 && errno == EINTR) continue;
+                if (written <= 0) {
+                    result = false;
+                    break;
+                }
+                done += written;
+            }
+            if (result) offset += read;
+        }
+        free(chunk);
+    }
+
+    result = close(target) == 0 && result;
+    if (copied) *copied = offset;
+    return result;
+}
+
+bool fview(file_view_t* view, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    struct stat attributes;
+    if (fstat(fileno(file), &attributes) != 0) {
+        fclose(file);
+        return false;
+    }
+
+    const size_t size = attributes.st_size;
+    if (size > 0 && S_ISREG(attributes.st_mode)) {
+        const char* data = mmap(
+            NULL, size, PROT_READ, MAP_PRIVATE, fileno(file), 0
+        );
+        if (data != MAP_FAILED) {
+            fclose(file);
+            *view = (file_view_t) {
+                .data = data, .size = size, .mapped = true
+            };
+            return true;
+        }
+    }
+
+    const bool result = fview_read(view, file, size);
+    fclose(file);
+    return result;
+}
+
+void fview_release(file_view_t* view) {
+    if (view->mapped) munmap((void*)view->data, view->size);
+    else free((char*)view->data);
+    *view = (file_view_t) { 0 };
 }
 
 bool can_access(const char* path) {
@@ -259,59 +539,46 @@ bool make_dir(const char* path) {
 }
 
 int list_files(const char* dir_path, char*** buffer) {
-
-    struct dirent* dir_entity;
-    int total_entities = 0;
-    struct stat file_attributes;
-    char** temp_buffer = NULL;
-
     DIR* dir = opendir(dir_path);
     if (!dir) {
         return 0;
     }
 
-    while ((dir_entity = readdir(dir)) != NULL) {
-        char full_path[1024];
-        snprintf(
-            full_path,
-            sizeof(full_path),
-            "%s/%s",
-            dir_path,
-            dir_entity->d_name
-        );
-        if (
-            stat(full_path, &file_attributes) == 0 &&
-            S_ISREG(file_attributes.st_mode)
-        ) {
-            total_entities++;
-        }
-    }
-
-    temp_buffer = (char**)malloc(total_entities * sizeof(char*));
-    if (!temp_buffer) {
-        closedir(dir);
-        return 0;
-    }
+    const int fd = dirfd(dir);
+    const size_t dir_length = strlen(dir_path);
+    int total_entities = 0;
+    int capacity = 0;
+    char** temp_buffer = NULL;
 
-    rewinddir(dir);
-    int index = 0;
+    struct dirent* dir_entity;
     while ((dir_entity = readdir(dir)) != NULL) {
-        char full_path[1024];
-        snprintf(
-            full_path,
-            sizeof(full_path),
-            "%s/%s",
-            dir_path,
-            dir_entity->d_name
-        );
+        // Only entries the directory does not tell the type of,
+        // and links, that can point to a file, are looked up.
+        if (dir_entity->d_type != DT_REG) {
+            if (dir_entity->d_type != DT_UNKNOWN &&
+                dir_entity->d_type != DT_LNK
+            ) continue;
+
+            struct stat file_attributes;
+            if (fstatat(fd, dir_entity->d_name, &file_attributes, 0) != 0 ||
+                !S_ISREG(file_attributes.st_mode)
+            ) continue;
+        }
 
-        if (
-            stat(full_path, &file_attributes) == 0 &&
-            S_ISREG(file_attributes.st_mode)
-        ) {
-            temp_buffer[index] = strdup(full_path);
-            index++;
+        if (total_entities == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            char** grown = realloc(temp_buffer, capacity * sizeof(char*));
+            if (!grown) break;
+            temp_buffer = grown;
         }
+
+        const size_t name_length = strlen(dir_entity->d_name);
+        char* full_path = malloc(dir_length + name_length + 2);
+        if (!full_path) break;
+        memcpy(full_path, dir_path, dir_length);
+        full_path[dir_length] = '/';
+        memcpy(full_path + dir_length + 1, dir_entity->d_name, name_length + 1);
+        temp_buffer[total_entities++] = full_path;
     }
 
     closedir(dir);
@@ -320,3 +587,103 @@ int list_files(const char* dir_path, char*** buffer) {
 }
 
 #endif
+
+
+
+/**
+ * @brief A directory of replaced files, which is part of their path.
+ */
+struct parent_s {
+    const char* path;
+    size_t length;
+};
+
+static int compare_parents(const void* first, const void* second) {
+    const struct parent_s* a = first;
+    const struct parent_s* b = second;
+    const int order = memcmp(
+        a->path, b->path, a->length < b->length ? a->length : b->length
+    );
+    if (order) return order;
+    return (a->length > b->length) - (a->length < b->length);
+}
+
+static struct parent_s parent_of(const char* path) {
+    const char* separator = str_last_separator(path, strlen(path));
+    if (!separator) return (struct parent_s) { .path = ".", .length = 1 };
+    return (struct parent_s) {
+        .path = path,
+        .length = separator == path ? 1 : (size_t)(separator - path)
+    };
+}
+
+/**
+ * @brief Sets the path of the temporary file the content of a file is staged in.
+ *
+ * It is next to the file, as renames are only atomic inside of a file system.
+ */
+static bool atomic_temp(path_t* temp_path, const char* path) {
+    static atomic_uint counter = 0;
+    char suffix[48];
+    const int length = snprintf(
+        suffix, sizeof(suffix), ".%lu-%u.tmp",
+        process_id(), atomic_fetch_add(&counter, 1)
+    );
+    return path_set(temp_path, path) &&
+        path_append(temp_path, suffix, length);
+}
+
+bool fwrite_atomic(const char* path, const void* data, const size_t size) {
+    const file_write_t content = { .path = path, .data = data, .size = size };
+    return fwrite_atomic_batch(&content, 1) == 1;
+}
+
+size_t fwrite_atomic_batch(const file_write_t* writes, const size_t count) {
+    path_t* temp_paths = calloc(count, sizeof(path_t));
+    struct parent_s* parents = malloc(count * sizeof(struct parent_s));
+    if (!temp_paths || !parents) {
+        perror("Files cannot be written");
+        free(temp_paths);
+        free(parents);
+        return 0;
+    }
+
+    // Staged files keep their temporary path, the others are released.
+    for (size_t i = 0; i < count; i++) {
+        if (atomic_temp(&temp_paths[i], writes[i].path) &&
+            atomic_stage(&writes[i], path_str(&temp_paths[i]))
+        ) continue;
+        fprintf(stderr, "File %s cannot be written.\n", writes[i].path);
+        if (temp_paths[i].length) remove(path_str(&temp_paths[i]));
+        path_release(&temp_paths[i]);
+    }
+
+    size_t replaced = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!temp_paths[i].length) continue;
+        if (atomic_replace(path_str(&temp_paths[i]), writes[i].path)) {
+            parents[replaced++] = parent_of(writes[i].path);
+        } else {
+            fprintf(stderr, "File %s cannot be replaced.\n", writes[i].path);
+            remove(path_str(&temp_paths[i]));
+        }
+        path_release(&temp_paths[i]);
+    }
+
+    // Files in the same directory are renamed into it with a single sync.
+    qsort(parents, replaced, sizeof(struct parent_s), compare_parents);
+    path_t dir = { 0 };
+    for (size_t i = 0; i < replaced; i++) {
+        if (i > 0 && compare_parents(&parents[i - 1], &parents[i]) == 0)
+            continue;
+        path_set(&dir, "");
+        if (!path_append(&dir, parents[i].path, parents[i].length) ||
+            !dir_sync(path_str(&dir))
+        ) fprintf(stderr, "Directory %s cannot be synced.\n", path_str(&dir));
+    }
+    path_release(&dir);
+
+    free(temp_paths);
+    free(parents);
+    return replaced;
+}
@@ -0,0 +1,345 @@
+
+// Copyright (c) 2025 Lenny Siebert
+//
+// This software is dual-licensed:
+//
+// 1. Open Source License:
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License version 3
+//    as published by the Free Software Foundation.
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY. See the GNU General Public
+//    License for more details: https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// 2. Commercial License:
+//    A commercial license will be available at a later time for use in commercial products.
+
+#include "directory.h"
+#include "path.h"
+#include <threads.h>
+
+
+/**
+ * @brief A directory that is waiting to be read.
+ */
+struct pending_s {
+    const char* path;
+    uint32_t length;
+};
+
+/**
+ * @brief Shared state of all threads of a walk.
+ *
+ * The queue holds the directories nobody is reading yet, busy counts
+ * the threads that are reading one. Once both are zero, the walk is done.
+ */
+struct walk_s {
+    bool recursive;
+    bool failed;
+    mtx_t lock;
+    cnd_t wake;
+    struct pending_s* queue;
+    size_t queued;
+    size_t queue_capacity;
+    size_t busy;
+    const char* root;
+};
+
+/**
+ * @brief The entries a thread found and the directories it found last.
+ */
+struct walker_s {
+    struct walk_s* walk;
+    arena_t* arena;
+    dir_entry_t* entries;
+    size_t count;
+    size_t capacity;
+    struct pending_s* found;
+    size_t found_count;
+    size_t found_capacity;
+};
+
+/**
+ * @brief Joins the path of the directory and the name and adds the entry.
+ */
+static bool walker_add(
+    struct walker_s* walker, const struct pending_s* dir,
+    const char* name, const size_t name_length, const dir_entry_type_t type
+) {
+    if (walker->count == walker->capacity) {
+        const size_t capacity = walker->capacity ? walker->capacity * 2 : 256;
+        dir_entry_t* entries = realloc(
+            walker->entries, capacity * sizeof(dir_entry_t)
+        );
+        if (!entries) return false;
+        walker->entries = entries;
+        walker->capacity = capacity;
+    }
+
+    const size_t length = dir->length + 1 + name_length;
+    char* path = arena_alloc(walker->arena, length + 1, 1);
+    if (!path) return false;
+    memcpy(path, dir->path, dir->length);
+    path[dir->length] = '/';
+    memcpy(path + dir->length + 1, name, name_length + 1);
+
+    walker->entries[walker->count++] = (dir_entry_t) {
+        .path = path,
+        .length = length,
+        .name = dir->length + 1,
+        .type = type
+    };
+    if (type != entry_directory || !walker->walk->recursive) return true;
+
+    if (walker->found_count == walker->found_capacity) {
+        const size_t capacity = walker->found_capacity ?
+            walker->found_capacity * 2 : 64;
+        struct pending_s* found = realloc(
+            walker->found, capacity * sizeof(struct pending_s)
+        );
+        if (!found) return false;
+        walker->found = found;
+        walker->found_capacity = capacity;
+    }
+    walker->found[walker->found_count++] = (struct pending_s) {
+        .path = path,
+        .length = length
+    };
+    return true;
+}
+
+
+
+#ifdef _WIN32
+#include <windows.h>
+
+static bool walker_scan(struct walker_s* walker, const struct pending_s* dir) {
+    path_t search_path = { 0 };
+    if (!path_append(&search_path, dir->path, dir->length) ||
+        !path_join(&search_path, "*")
+    ) {
+        path_release(&search_path);
+        return false;
+    }
+
+    WIN32_FIND_DATA found;
+    const HANDLE find = FindFirstFileEx(
+        path_str(&search_path), FindExInfoBasic, &found,
+        FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH
+    );
+    path_release(&search_path);
+    if (find == INVALID_HANDLE_VALUE) return false;
+
+    bool result = true;
+    do {
+        const char* name = found.cFileName;
+        if (name[0] == '.' && (!name[1] || (name[1] == '.' && !name[2])))
+            continue;
+
+        dir_entry_type_t type = entry_file;
+        if (found.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)
+            type = entry_link;
+        else if (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            type = entry_directory;
+        result = walker_add(walker, dir, name, strlen(name), type);
+    } while (result && FindNextFile(find, &found));
+
+    FindClose(find);
+    return result;
+}
+
+
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+static dir_entry_type_t type_of_mode(const mode_t mode) {
+    if (S_ISREG(mode)) return entry_file;
+    if (S_ISDIR(mode)) return entry_directory;
+    if (S_ISLNK(mode)) return entry_link;
+    return entry_other;
+}
+
+static bool walker_scan(struct walker_s* walker, const struct pending_s* dir) {
+    DIR* handle = opendir(dir->path);
+    if (!handle) return false;
+
+    const int fd = dirfd(handle);
+    bool result = true;
+    struct dirent* entity;
+    while (result && (entity = readdir(handle)) != NULL) {
+        const char* name = entity->d_name;
+        if (name[0] == '.' && (!name[1] || (name[1] == '.' && !name[2])))
+            continue;
+
+        dir_entry_type_t type;
+        switch (entity->d_type) {
+            case DT_REG: type = entry_file; break;
+            case DT_DIR: type = entry_directory; break;
+            case DT_LNK: type = entry_link; break;
+            case DT_UNKNOWN: {
+                struct stat attributes;
+                if (fstatat(fd, name, &attributes, AT_SYMLINK_NOFOLLOW) != 0)
+                    continue;
+                type = type_of_mode(attributes.st_mode);
+                break;
+            }
+            default: type = entry_other; break;
+        }
+        result = walker_add(walker, dir, name, strlen(name), type);
+    }
+
+    closedir(handle);
+    return result;
+}
+
+#endif
+
+
+
+/**
+ * @brief Reads directories from the queue until the walk is done.
+ *
+ * The directories found in one directory are queued at once.
+ */
+static int walker_run(void* argument) {
+    struct walker_s* walker = argument;
+    struct walk_s* walk = walker->walk;
+
+    mtx_lock(&walk->lock);
+    while (true) {
+        while (walk->queued == 0 && walk->busy > 0)
+            cnd_wait(&walk->wake, &walk->lock);
+        if (walk->queued == 0) break;
+
+        const struct pending_s dir = walk->queue[--walk->queued];
+        walk->busy++;
+        mtx_unlock(&walk->lock);
+
+        walker->found_count = 0;
+        const bool scanned = walker_scan(walker, &dir);
+
+        mtx_lock(&walk->lock);
+        walk->busy--;
+        if (!scanned && dir.path == walk->root) walk->failed = true;
+
+        if (walk->queued + walker->found_count > walk->queue_capacity) {
+            size_t capacity = walk->queue_capacity * 2;
+            while (capacity < walk->queued + walker->found_count) capacity *= 2;
+            struct pending_s* queue = realloc(
+                walk->queue, capacity * sizeof(struct pending_s)
+            );
+            if (!queue) {
+                walk->failed = true;
+                walker->found_count = 0;
+            } else {
+                walk->queue = queue;
+                walk->queue_capacity = capacity;
+            }
+        }
+        memcpy(
+            walk->queue + walk->queued, walker->found,
+            walker->found_count * sizeof(struct pending_s)
+        );
+        walk->queued += walker->found_count;
+        if (walker->found_count > 1 || walk->busy == 0)
+            cnd_broadcast(&walk->wake);
+    }
+    mtx_unlock(&walk->lock);
+    return 0;
+}
+
+bool dir_walk(
+    dir_listing_t* listing, const char* dir_path,
+    const bool recursive, size_t thread_count
+) {
+    *listing = (dir_listing_t) { 0 };
+    if (thread_count == 0) thread_count = 1;
+
+    size_t root_length = strlen(dir_path);
+    while (root_length > 1 &&
+        (dir_path[root_length - 1] == '/' || dir_path[root_length - 1] == '\\')
+    ) root_length--;
+
+    struct walk_s walk = {
+        .recursive = recursive,
+        .failed = false,
+        .queue = malloc(64 * sizeof(struct pending_s)),
+        .queued = 1,
+        .queue_capacity = 64,
+        .busy = 0,
+        .root = dir_path
+    };
+    struct walker_s* walkers = calloc(thread_count, sizeof(struct walker_s));
+    thrd_t* threads = calloc(thread_count, sizeof(thrd_t));
+    if (!walk.queue || !walkers || !threads) {
+        perror("Failed to walk directory");
+        free(walk.queue);
+        free(walkers);
+        free(threads);
+        return false;
+    }
+    walk.queue[0] = (struct pending_s) {
+        .path = dir_path,
+        .length = root_length
+    };
+    mtx_init(&walk.lock, mtx_plain);
+    cnd_init(&walk.wake);
+
+    size_t started = 1;
+    for (size_t i = 0; i < thread_count; i++) {
+        walkers[i].walk = &walk;
+        walkers[i].arena = arena_create(64 * 1024);
+        if (!walkers[i].arena) walk.failed = true;
+    }
+    if (!walk.failed) {
+        for (; started < thread_count; started++) if (thrd_create(
+            &threads[started], walker_run, &walkers[started]
+        ) != thrd_success) break;
+        walker_run(&walkers[0]);
+        for (size_t i = 1; i < started; i++) thrd_join(threads[i], NULL);
+    }
+
+    // The entries of all threads are moved to the first one.
+    size_t count = 0;
+    for (size_t i = 0; i < thread_count; i++) count += walkers[i].count;
+    dir_entry_t* entries = count > walkers[0].capacity ? realloc(
+        walkers[0].entries, count * sizeof(dir_entry_t)
+    ) : walkers[0].entries;
+    if (!entries) walk.failed = true;
+
+    listing->arena = walkers[0].arena;
+    listing->entries = entries ? entries : walkers[0].entries;
+    listing->count = walkers[0].count;
+    for (size_t i = 1; i < thread_count; i++) {
+        if (entries) {
+            memcpy(
+                entries + listing->count, walkers[i].entries,
+                walkers[i].count * sizeof(dir_entry_t)
+            );
+            listing->count += walkers[i].count;
+        }
+        if (listing->arena && walkers[i].arena)
+            arena_adopt(listing->arena, walkers[i].arena);
+        else arena_del(walkers[i].arena);
+        free(walkers[i].entries);
+    }
+    for (size_t i = 0; i < thread_count; i++) free(walkers[i].found);
+
+    cnd_destroy(&walk.wake);
+    mtx_destroy(&walk.lock);
+    free(walk.queue);
+    free(walkers);
+    free(threads);
+    if (!walk.failed) return true;
+
+    dir_listing_release(listing);
+    return false;
+}
+
+void dir_listing_release(dir_listing_t* listing) {
+    free(listing->entries);
+    arena_del(listing->arena);
+    *listing = (dir_listing_t) { 0 };
+}
@@ -0,0 +1,208 @@
+
+// Copyright (c) 2025 Lenny Siebert
+//
+// This software is dual-licensed:
+//
+// 1. Open Source License:
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License version 3
+//    as published by the Free Software Foundation.
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY. See the GNU General Public
+//    License for more details: https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// 2. Commercial License:
+//    A commercial license will be available at a later time for use in commercial products.
+
+#include "info.h"
+#include "arena.h"
+#include "path.h"
+#include <threads.h>
+
+
+/**
+ * @brief The directories of the platform, allocated from their own arena.
+ */
+static struct {
+    const char* dirs[location_temp + 1];
+    arena_t* arena;
+} info;
+
+static once_flag info_once = ONCE_FLAG_INIT;
+
+/**
+ * @brief Keeps the path of a directory for the lifetime of the program.
+ *
+ * Separators at the end are removed, except of the one of the root.
+ */
+static void info_keep(const info_location_t location, const path_t* path) {
+    const char* data = path_str(path);
+    size_t length = path->length;
+    while (length > 1 && (data[length - 1] == '/' || data[length - 1] == '\\') &&
+        data[length - 2] != ':'
+    ) length--;
+    if (length > 0) info.dirs[location] = arena_strndup(info.arena, data, length);
+}
+
+/**
+ * @brief Sets the path to an absolute path of the environment.
+ */
+static bool info_env(path_t* path, const char* name) {
+    const char* value = getenv(name);
+    return value && value[0] && path_set(path, value);
+}
+
+
+
+#ifdef _WIN32
+#include <windows.h>
+
+static bool info_work(path_t* path) {
+    const DWORD size = GetCurrentDirectory(0, NULL);
+    char* buffer = size ? malloc(size) : NULL;
+    const bool result = buffer && GetCurrentDirectory(size, buffer) > 0 &&
+        path_set(path, buffer);
+    free(buffer);
+    return result;
+}
+
+static bool info_executable(path_t* path) {
+    for (DWORD size = MAX_PATH;; size *= 2) {
+        char* buffer = malloc(size);
+        if (!buffer) return false;
+        const DWORD length = GetModuleFileName(NULL, buffer, size);
+        const bool result = length > 0 && length < size &&
+            path_set(path, buffer);
+        free(buffer);
+        if (length < size || size >= 32768) return result;
+    }
+}
+
+static bool info_config(path_t* path) {
+    return info_env(path, "APPDATA");
+}
+
+static bool info_cache(path_t* path) {
+    return info_env(path, "LOCALAPPDATA");
+}
+
+static bool info_temp(path_t* path) {
+    char buffer[MAX_PATH + 1];
+    const DWORD length = GetTempPath(sizeof(buffer), buffer);
+    return length > 0 && length < sizeof(buffer) && path_set(path, buffer);
+}
+
+
+#else
+#include <pwd.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <mach-o/dyld.h>
+#endif
+
+static bool info_work(path_t* path) {
+    char* buffer = getcwd(NULL, 0);
+    const bool result = buffer && path_set(path, buffer);
+    free(buffer);
+    return result;
+}
+
+static bool info_executable(path_t* path) {
+#ifdef __APPLE__
+    uint32_t size = 0;
+    _NSGetExecutablePath(NULL, &size);
+    char* buffer = malloc(size);
+    const bool result = buffer && _NSGetExecutablePath(buffer, &size) == 0 &&
+        path_set(path, buffer);
+    free(buffer);
+    return result;
+#else
+    // The length of the link is not known before, so it is read until it fits.
+    for (size_t size = 256;; size *= 2) {
+        char* buffer = malloc(size);
+        if (!buffer) return false;
+        const ssize_t length = readlink("/proc/self/exe", buffer, size);
+        const bool result = length > 0 && (size_t)length < size &&
+            path_append(path, buffer, length);
+        free(buffer);
+        if (length < 0 || (size_t)length < size) return result;
+    }
+#endif
+}
+
+/**
+ * @brief Sets the path to the home directory of the user.
+ */
+static bool info_home(path_t* path) {
+    if (info_env(path, "HOME")) return true;
+
+    struct passwd entry;
+    struct passwd* found = NULL;
+    char buffer[4096];
+    return getpwuid_r(getuid(), &entry, buffer, sizeof(buffer), &found) == 0 &&
+        found && path_set(path, found->pw_dir);
+}
+
+/**
+ * @brief Sets the path to a directory of the XDG base directory specification.
+ *
+ * Relative paths in the environment are invalid and ignored.
+ */
+static bool info_xdg(
+    path_t* path, const char* name, const char* home_dir, const char* apple_dir
+) {
+#ifndef __APPLE__
+    (void)apple_dir;
+    const char* value = getenv(name);
+    if (value && value[0] == '/') return path_set(path, value);
+    return info_home(path) && path_join(path, home_dir);
+#else
+    (void)name;
+    (void)home_dir;
+    return info_home(path) && path_join(path, apple_dir);
+#endif
+}
+
+static bool info_config(path_t* path) {
+    return info_xdg(
+        path, "XDG_CONFIG_HOME", ".config", "Library/Application Support"
+    );
+}
+
+static bool info_cache(path_t* path) {
+    return info_xdg(path, "XDG_CACHE_HOME", ".cache", "Library/Caches");
+}
+
+static bool info_temp(path_t* path) {
+    return info_env(path, "TMPDIR") || path_set(path, "/tmp");
+}
+
+#endif
+
+
+
+static void info_resolve(void) {
+    info.arena = arena_create(4096);
+    if (!info.arena) {
+        perror("Platform directories cannot be resolved");
+        return;
+    }
+
+    path_t path = { 0 };
+    if (info_work(&path)) info_keep(location_work, &path);
+    path_release(&path);
+    if (info_executable(&path) && path_parent(&path))
+        info_keep(location_executable, &path);
+    path_release(&path);
+    if (info_config(&path)) info_keep(location_config, &path);
+    path_release(&path);
+    if (info_cache(&path)) info_keep(location_cache, &path);
+    path_release(&path);
+    if (info_temp(&path)) info_keep(location_temp, &path);
+    path_release(&path);
+}
+
+const char* info_dir(const info_location_t location) {
+    call_once(&info_once, info_resolve);
+    return info.dirs[location];
+}
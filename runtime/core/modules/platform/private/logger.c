@@ -14,52 +14,18 @@
 //    A commercial license will be available at a later time for use in commercial products.
 
 #include "logger.h"
+#include "binary_log.h"
 #include "common.h"
+#include "path.h"
+#include "str.h"
+#include "timestamp.h"
+#include <errno.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#include <threads.h>
 
 
-static bool str_of_time(const struct tm* time, char* buffer) {
-    return sprintf(
-        buffer, "%02d:%02d:%02d, %02d-%02d-%d",
-        time->tm_hour, time->tm_min, time->tm_sec,
-        time->tm_mday, time->tm_mon + 1, time->tm_year + 1900
-    );
-}
-
-
-
-static struct tm* time_of_str(const char* str) {
-    struct tm* time = malloc(sizeof(struct tm));
-    if (!time) {
-        perror("Error while parsing time for the logger");
-        return NULL;
-    }
-
-    if (sscanf(
-        str, "%d-%d-%d__%d-%d-%d_",
-        &time->tm_hour, &time->tm_min, &time->tm_sec,
-        &time->tm_mday, &time->tm_mon, &time->tm_year
-    ) == 6) return time;
-
-    if (sscanf(
-        str, "%d:%d:%d, %d-%d-%d ",
-        &time->tm_hour, &time->tm_min, &time->tm_sec,
-        &time->tm_mday, &time->tm_mon, &time->tm_year
-    ) == 6) return time;
-
-    perror("Error while parsing time for the logger");
-    free(time);
-    return NULL;
-}
-
-
-
-static void replace_unknown_chars(char* buffer) {
-    for (size_t i = 0; i < strlen(buffer); i++) {
-        if (buffer[i] == ',' || buffer[i] == ' ') buffer[i] = '_';
-        else if (buffer[i] == ':') buffer[i] = '-';
-    }
-}
-
 struct name_s {
     int sign;
     char* name;
@@ -79,132 +45,905 @@ static struct name_s get_name(
     return names[sign];
 }
 
-static bool get_meta(
-    char* buffer, const size_t buffer_length, FILE* file
-) {
-    fseek(file, 0, SEEK_END);
-    const long file_size = ftell(file);
-    if (file_size == -1) {
-        perror("Error while seeking file size");
-        return false;
-    }
+/**
+ * @brief Length of the header line every owned log file starts with.
+ *
+ * The header is "#fireworks log ", the wall-clock second the file was
+ * created at as 20 digits, and the name of the logger padded with
+ * spaces. It has a fixed size, so its meta is read without a scan.
+ */
+#define LOGGER_META_SIZE 64
+#define LOGGER_META_MAGIC "#fireworks log "
+#define LOGGER_META_NAME (sizeof(LOGGER_META_MAGIC) - 1 + 21)
+
+/**
+ * @brief The path of an owned log file and when it rotates.
+ *
+ * The lock is held while the file is written, so a rotation
+ * never closes it in the middle of a line.
+ * A limit of zero never triggers a rotation.
+ * If the segment size is set, the file is written through a mapped
+ * segment of it, that starts at the map offset and is filled up to
+ * the cursor.
+ */
+struct logger_rotation_s {
+    path_t path;
+    path_t archive_dir;
+    size_t max_bytes;
+    uint64_t max_age;
+    size_t written;
+    uint64_t opened;
+    size_t segment;
+    char* map;
+    uint64_t map_offset;
+    size_t cursor;
+    mtx_t lock;
+};
+
 
-    int end = -1, start = -1;
-    for (long i = file_size - 1; i >= 0; i--) {
-        fseek(file, i, SEEK_SET);
-        char cur;
-        if (fread(&cur, 1, 1, file) != 1) {
-            perror("Error while reading file");
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+
+static size_t segment_granularity(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwAllocationGranularity;
+}
+
+static uint64_t segment_end(FILE* file) {
+    const long long end = _filelengthi64(_fileno(file));
+    return end < 0 ? 0 : end;
+}
+
+static char* segment_map(FILE* file, const uint64_t offset, const size_t size) {
+    const HANDLE handle = (HANDLE)_get_osfhandle(_fileno(file));
+    const uint64_t end = offset + size;
+    const HANDLE mapping = CreateFileMapping(
+        handle, NULL, PAGE_READWRITE, end >> 32, end & 0xFFFFFFFF, NULL
+    );
+    if (!mapping) return NULL;
+
+    char* map = MapViewOfFile(
+        mapping, FILE_MAP_WRITE, offset >> 32, offset & 0xFFFFFFFF, size
+    );
+    CloseHandle(mapping);
+    return map;
+}
+
+static void segment_unmap(char* map, const size_t size) {
+    (void)size;
+    UnmapViewOfFile(map);
+}
+
+static bool segment_sync(char* map, const size_t size) {
+    return FlushViewOfFile(map, size);
+}
+
+static bool segment_truncate(FILE* file, const uint64_t size) {
+    return _chsize_s(_fileno(file), size) == 0;
+}
+
+
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static size_t segment_granularity(void) {
+    return sysconf(_SC_PAGESIZE);
+}
+
+static uint64_t segment_end(FILE* file) {
+    struct stat attributes;
+    if (fstat(fileno(file), &attributes) != 0) return 0;
+    return attributes.st_size;
+}
+
+static char* segment_map(FILE* file, const uint64_t offset, const size_t size) {
+    const int fd = fileno(file);
+    if (posix_fallocate(fd, offset, size) != 0) return NULL;
+
+    char* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, offset);
+    return map == MAP_FAILED ? NULL : map;
+}
+
+static void segment_unmap(char* map, const size_t size) {
+    munmap(map, size);
+}
+
+static bool segment_sync(char* map, const size_t size) {
+    return msync(map, size, MS_SYNC) == 0;
+}
+
+static bool segment_truncate(FILE* file, const uint64_t size) {
+    return ftruncate(fileno(file), size) == 0;
+}
+
+#endif
+
+
+
+
+/**
+ * @brief Writes the header of a new log file.
+ */
+static bool meta_write(FILE* file, const char* name, const time_t created) {
+    char line[LOGGER_META_SIZE + 1];
+    memset(line, ' ', LOGGER_META_SIZE);
+    const int length = snprintf(
+        line, sizeof(line), LOGGER_META_MAGIC "%020lld %s",
+        (long long)created, name
+    );
+    if (length < 0) return false;
+    if (length < LOGGER_META_SIZE) line[length] = ' ';
+    line[LOGGER_META_SIZE - 1] = '\n';
+    return fwrite(line, 1, LOGGER_META_SIZE, file) == LOGGER_META_SIZE;
+}
+
+/**
+ * @brief Reads the creation time and logger name of a log file.
+ *
+ * The name buffer needs room for LOGGER_META_SIZE characters.
+ * Returns false for files without a valid header.
+ */
+static bool meta_read(const char* path, time_t* created, char* name) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    char line[LOGGER_META_SIZE];
+    const bool complete = fread(
+        line, 1, LOGGER_META_SIZE, file
+    ) == LOGGER_META_SIZE;
+    fclose(file);
+
+    if (!complete || line[LOGGER_META_SIZE - 1] != '\n' ||
+        memcmp(line, LOGGER_META_MAGIC, sizeof(LOGGER_META_MAGIC) - 1)
+    ) return false;
+
+    *created = (time_t)strtoll(
+        line + sizeof(LOGGER_META_MAGIC) - 1, NULL, 10
+    );
+    size_t length = LOGGER_META_SIZE - 1 - LOGGER_META_NAME;
+    while (length > 0 && line[LOGGER_META_NAME + length - 1] == ' ')
+        length--;
+    memcpy(name, line + LOGGER_META_NAME, length);
+    name[length] = '\0';
+    return true;
+}
+
+/**
+ * @brief Moves a log file into the archive directory.
+ *
+ * The archived file is named after the creation time and logger name
+ * of its header. Files without one are named after their last
+ * modification and the given name. The file is renamed, its
+ * content is never copied.
+ */
+static bool archive(
+    const char* path, const char* archive_dir, const char* fallback_name
+) {
+    time_t created;
+    char name[LOGGER_META_SIZE];
+    if (!meta_read(path, &created, name)) {
+        struct stat attributes;
+        if (stat(path, &attributes) != 0) {
+            perror("Log file cannot be archived");
             return false;
         }
+        created = attributes.st_mtime;
+        snprintf(name, sizeof(name), "%s", fallback_name);
+    }
+    for (char* cur = name; *cur; cur++)
+        if (!isalnum((unsigned char)*cur) && *cur != '-' && *cur != '.')
+            *cur = '-';
+
+    struct tm local;
+    if (!timestamp_local(created, &local)) return false;
+    if (!can_access(archive_dir)) make_dir(archive_dir);
+
+    // Files created in the same second are numbered.
+    char archived_name[LOGGER_META_SIZE + 48];
+    path_t archived = { 0 };
+    bool result = false;
+    for (int i = 0; i < 1000; i++) {
+        const int length = snprintf(
+            archived_name, sizeof(archived_name), "%02d-%02d-%02d__%02d-%02d-%d_%s",
+            local.tm_hour, local.tm_min, local.tm_sec,
+            local.tm_mday, local.tm_mon + 1, local.tm_year + 1900, name
+        );
+        if (i > 0) snprintf(
+            archived_name + length, sizeof(archived_name) - length, "-%d", i
+        );
+        if (!path_set(&archived, archive_dir) ||
+            !path_join(&archived, archived_name) ||
+            !path_append(&archived, ".log", 4)
+        ) break;
+        if (can_access(path_str(&archived))) continue;
+        result = rename(path, path_str(&archived)) == 0;
+        break;
+    }
+    if (!result) fprintf(stderr, "Log file %s cannot be archived.\n", path);
+    path_release(&archived);
+    return result;
+}
 
-        if (cur == ')' && end == -1) end = i;
-        else if (cur == '(') {
-            start = i;
-            break;
+/**
+ * @brief Opens the file of the rotation and writes its header.
+ *
+ * If the file still exists, it is appended to.
+ */
+static FILE* rotation_open(logger_rotation_t* rotation, const char* name) {
+    const bool exists = can_access(path_str(&rotation->path));
+    FILE* file = fopen(path_str(&rotation->path), "a+b");
+    if (!file) {
+        perror("Log file cannot be opened");
+        return NULL;
+    }
+
+    rotation->written = 0;
+    rotation->opened = timestamp_mono();
+    if (!exists) meta_write(file, name, time(NULL));
+    return file;
+}
+
+/**
+ * @brief Maps the segment of the file that holds its end.
+ *
+ * The mapping starts at the last offset the platform can map from
+ * and the cursor points to the end behind the content before.
+ */
+static bool segment_open(logger_rotation_t* rotation, FILE* file) {
+    fflush(file);
+    const uint64_t end = segment_end(file);
+    const size_t granularity = segment_granularity();
+
+    rotation->map_offset = end - end % granularity;
+    rotation->cursor = end - rotation->map_offset;
+    rotation->map = segment_map(file, rotation->map_offset, rotation->segment);
+    if (rotation->map) return true;
+
+    segment_truncate(file, end);
+    perror("Log file cannot be mapped");
+    return false;
+}
+
+/**
+ * @brief Writes back and unmaps the segment and cuts off the unused rest.
+ */
+static bool segment_close(logger_rotation_t* rotation, FILE* file) {
+    if (!rotation->map) return true;
+    bool result = segment_sync(rotation->map, rotation->segment);
+    segment_unmap(rotation->map, rotation->segment);
+    rotation->map = NULL;
+    return segment_truncate(
+        file, rotation->map_offset + rotation->cursor
+    ) && result;
+}
+
+/**
+ * @brief Writes to the file of the logger, which has to be locked.
+ *
+ * Mapped files get the data copied behind the cursor of the segment,
+ * the next segment is mapped once it is full. If it cannot be mapped,
+ * the file is written through the stream again.
+ * Returns the count of written bytes.
+ */
+static size_t file_put(
+    logger_t* logger, FILE* file, const char* data, const size_t size
+) {
+    logger_rotation_t* rotation = logger->rotation;
+    if (!rotation || !rotation->map) return fwrite(data, 1, size, file);
+
+    size_t written = 0;
+    while (written < size) {
+        if (rotation->cursor == rotation->segment) {
+            segment_unmap(rotation->map, rotation->segment);
+            rotation->map_offset += rotation->segment;
+            rotation->cursor = 0;
+            if (!segment_open(rotation, file))
+                return written + fwrite(data + written, 1, size - written, file);
         }
+
+        size_t length = rotation->segment - rotation->cursor;
+        if (length > size - written) length = size - written;
+        memcpy(rotation->map + rotation->cursor, data + written, length);
+        rotation->cursor += length;
+        written += length;
     }
+    return written;
+}
 
-    if (start == -1 || end == -1 || start >= end)
-        return false;
+/**
+ * @brief Writes the pieces to the file of the logger, which has to be locked.
+ *
+ * Returns the count of written bytes.
+ */
+static size_t file_put_vectored(
+    logger_t* logger, FILE* file,
+    const io_vector_t* vectors, const size_t count
+) {
+    size_t written = 0;
+    if (!logger->rotation || !logger->rotation->map) {
+        if (!fwrite_vectored(file, vectors, count)) return 0;
+        for (size_t i = 0; i < count; i++) written += vectors[i].size;
+        return written;
+    }
 
-    const size_t size = (end - start - 1);
-    if (size >= buffer_length) return false;
+    for (size_t i = 0; i < count; i++)
+        written += file_put(logger, file, vectors[i].data, vectors[i].size);
+    return written;
+}
 
-    fseek(file, start + 1, SEEK_SET);
-    if (fread(buffer, 1, size, file) != size) {
-        perror("Error while reading file content");
-        return false;
+/**
+ * @brief Archives the full log file and continues in a new one.
+ *
+ * If the file cannot be archived, the logger keeps writing to it
+ * until the limits are reached again.
+ */
+static void rotate(logger_t* logger) {
+    logger_rotation_t* rotation = logger->rotation;
+    segment_close(rotation, logger->file);
+    fclose(logger->file);
+    archive(
+        path_str(&rotation->path), path_str(&rotation->archive_dir),
+        logger->name
+    );
+
+    FILE* file = rotation_open(rotation, logger->name);
+    if (file && rotation->segment) segment_open(rotation, file);
+    logger->file = file;
+}
+
+/**
+ * @brief Locks the file of the logger against a rotation.
+ *
+ * Returns the file, that can be written until file_unlock().
+ */
+static FILE* file_lock(logger_t* logger) {
+    if (logger->rotation) mtx_lock(&logger->rotation->lock);
+    return logger->file;
+}
+
+/**
+ * @brief Counts the written bytes and rotates the file if a limit is reached.
+ */
+static void file_unlock(logger_t* logger, const size_t written) {
+    logger_rotation_t* rotation = logger->rotation;
+    if (!rotation) return;
+
+    rotation->written += written;
+    if (logger->file && logger->own_file && (
+        (rotation->max_bytes && rotation->written >= rotation->max_bytes) ||
+        (rotation->max_age &&
+            timestamp_mono() - rotation->opened >= rotation->max_age)
+    )) rotate(logger);
+    mtx_unlock(&rotation->lock);
+}
+
+
+
+/**
+ * @brief Length of the text a single ring buffer record can hold.
+ */
+#define LOGGER_RECORD_LENGTH 480
+
+/**
+ * @brief Count of shards a thread remembers without searching.
+ */
+#define LOGGER_OWNED_SHARDS 4
+
+/**
+ * @brief A formatted line in a shard of an asynchronous logger.
+ *
+ * The stamp is the monotonic time the message was written at and
+ * orders the records of all shards. The group is the count of records
+ * of the same message, set at its first record, so a sequence is
+ * never split up. The text is the line for the file, stdout only gets
+ * the part from the stdout offset on.
+ */
+struct record_s {
+    uint64_t stamp;
+    uint32_t group;
+    size_t length;
+    size_t stdout_offset;
+    bool print_out;
+    bool to_file;
+    char text[LOGGER_RECORD_LENGTH];
+};
+
+/**
+ * @brief Ring buffer of a single producing thread.
+ *
+ * Only the owner moves the head and only the flusher moves the tail,
+ * so a shard needs no lock and no compare and swap.
+ * The cursor and end are the merge state of the flusher.
+ * Shards stay in the list until the logger is disposed.
+ */
+struct shard_s {
+    struct record_s* records;
+    thrd_t owner;
+    alignas(64) atomic_size_t head;
+    alignas(64) atomic_size_t tail;
+    size_t cursor;
+    size_t end;
+    struct shard_s* next;
+};
+
+struct logger_async_s {
+    uint64_t id;
+    size_t mask;
+    logger_overflow_t overflow;
+    logger_t* logger;
+    _Atomic(struct shard_s*) shards;
+    atomic_bool running;
+    atomic_bool idle;
+    mtx_t lock;
+    cnd_t wake;
+    thrd_t flusher;
+};
+
+/**
+ * @brief Source of the ids of asynchronous loggers.
+ *
+ * Ids are never reused, so a thread can not mistake the shard
+ * of a disposed logger for one of a new logger.
+ */
+static atomic_uint_fast64_t async_ids = 1;
+
+/**
+ * @brief The shards the current thread used last, by the id of their logger.
+ */
+static thread_local struct {
+    uint64_t id;
+    struct shard_s* shard;
+} owned[LOGGER_OWNED_SHARDS];
+static thread_local size_t owned_next = 0;
+
+static struct record_s* record_at(
+    const logger_async_t* async, const struct shard_s* shard,
+    const size_t position
+) {
+    return &shard->records[position & async->mask];
+}
+
+static bool pending(logger_async_t* async) {
+    for (struct shard_s* shard = atomic_load(&async->shards);
+        shard; shard = shard->next
+    ) if (atomic_load(&shard->tail) != atomic_load(&shard->head)) return true;
+    return false;
+}
+
+static void wake_flusher(logger_async_t* async) {
+    if (!atomic_load(&async->idle)) return;
+    mtx_lock(&async->lock);
+    cnd_signal(&async->wake);
+    mtx_unlock(&async->lock);
+}
+
+/**
+ * @brief Gets the shard of the current thread and creates it on first use.
+ */
+static struct shard_s* shard_of(logger_async_t* async) {
+    for (size_t i = 0; i < LOGGER_OWNED_SHARDS; i++)
+        if (owned[i].id == async->id) return owned[i].shard;
+
+    const thrd_t self = thrd_current();
+    struct shard_s* shard = atomic_load(&async->shards);
+    while (shard && !thrd_equal(shard->owner, self)) shard = shard->next;
+
+    if (!shard) {
+        shard = malloc(sizeof(struct shard_s));
+        if (!shard) {
+            perror("Failed to create shard of the logger");
+            return NULL;
+        }
+        shard->records = malloc((async->mask + 1) * sizeof(struct record_s));
+        if (!shard->records) {
+            perror("Failed to create ring buffer of the logger");
+            free(shard);
+            return NULL;
+        }
+        shard->owner = self;
+        atomic_init(&shard->head, 0);
+        atomic_init(&shard->tail, 0);
+        shard->cursor = 0;
+        shard->end = 0;
+
+        shard->next = atomic_load(&async->shards);
+        while (!atomic_compare_exchange_weak(
+            &async->shards, &shard->next, shard
+        ));
     }
 
-    buffer[size] = '\0';
+    owned[owned_next].id = async->id;
+    owned[owned_next].shard = shard;
+    owned_next = (owned_next + 1) % LOGGER_OWNED_SHARDS;
+    return shard;
+}
+
+/**
+ * @brief Reserves count consecutive records of the shard.
+ *
+ * Returns false if the shard is full and the message should be dropped.
+ */
+static bool reserve(
+    logger_async_t* async, struct shard_s* shard,
+    const logger_significance_t sign, const size_t count, size_t* position
+) {
+    if (count > async->mask + 1) return false;
+    const bool blocking = async->overflow == overflow_block ||
+        (async->overflow == overflow_drop_info && sign != info);
+
+    const size_t pos = atomic_load_explicit(&shard->head, memory_order_relaxed);
+    while (pos + count - atomic_load_explicit(
+        &shard->tail, memory_order_acquire
+    ) > async->mask + 1) {
+        if (!blocking) return false;
+        wake_flusher(async);
+        thrd_yield();
+    }
+    *position = pos;
     return true;
 }
 
+/**
+ * @brief Copies a line into a record.
+ *
+ * Truncated lines still end with a line break.
+ */
+static void record_copy(
+    struct record_s* record, const char* line,
+    size_t length, const size_t stdout_offset
+) {
+    if (length > LOGGER_RECORD_LENGTH) {
+        length = LOGGER_RECORD_LENGTH;
+        memcpy(record->text, line, length - 1);
+        record->text[length - 1] = '\n';
+    }
+    else memcpy(record->text, line, length);
+
+    record->length = length;
+    record->stdout_offset = stdout_offset < length ? stdout_offset : length;
+}
 
+/**
+ * @brief Writes a prefix, a message and a line break into a record.
+ *
+ * Long messages are truncated to fit the record.
+ */
+static void record_line(
+    struct record_s* record, const char* prefix, size_t prefix_length,
+    const char* message, const size_t stdout_offset
+) {
+    if (prefix_length > LOGGER_RECORD_LENGTH - 1)
+        prefix_length = LOGGER_RECORD_LENGTH - 1;
+    size_t length = strlen(message);
+    if (length > LOGGER_RECORD_LENGTH - prefix_length - 1)
+        length = LOGGER_RECORD_LENGTH - prefix_length - 1;
+
+    memcpy(record->text, prefix, prefix_length);
+    memcpy(record->text + prefix_length, message, length);
+    record->text[prefix_length + length] = '\n';
+    record->length = prefix_length + length + 1;
+    record->stdout_offset = stdout_offset < prefix_length ?
+        stdout_offset : prefix_length;
+}
 
-static bool archive(const char* file_path) {
-    FILE* old_file = fopen(file_path, "r");
-    if (!old_file) {
-        fprintf(stderr,
-            "Can't open log file to archive its content."
+/**
+ * @brief Merges all published records of the shards by their stamp and writes them.
+ *
+ * A record published after the drain started is written by the next
+ * drain, even if its stamp is older than the records written now.
+ * Returns the count of records that were written.
+ */
+static size_t drain(logger_async_t* async) {
+    struct shard_s* const shards = atomic_load(&async->shards);
+    for (struct shard_s* shard = shards; shard; shard = shard->next) {
+        shard->cursor = atomic_load_explicit(
+            &shard->tail, memory_order_relaxed
+        );
+        shard->end = atomic_load_explicit(
+            &shard->head, memory_order_acquire
         );
-        return false;
     }
-    const size_t meta_size = 64;
-    char meta[meta_size];
-    if (!get_meta(meta, meta_size, old_file)) {
-        fprintf(stderr, "No valid meta in %s.\n", file_path);
-        fclose(old_file);
-        return false;
+
+    FILE* file = file_lock(async->logger);
+    size_t count = 0, written = 0;
+    while (true) {
+        struct shard_s* next = NULL;
+        uint64_t next_stamp = 0;
+        for (struct shard_s* shard = shards; shard; shard = shard->next) {
+            if (shard->cursor == shard->end) continue;
+            const uint64_t stamp =
+                record_at(async, shard, shard->cursor)->stamp;
+            if (next && stamp >= next_stamp) continue;
+            next = shard;
+            next_stamp = stamp;
+        }
+        if (!next) break;
+
+        const uint32_t group = record_at(async, next, next->cursor)->group;
+        for (uint32_t i = 0; i < group; i++) {
+            const struct record_s* record =
+                record_at(async, next, next->cursor + i);
+            if (record->print_out) fwrite(
+                record->text + record->stdout_offset, sizeof(char),
+                record->length - record->stdout_offset, stdout
+            );
+            if (record->to_file && file) written += file_put(
+                async->logger, file, record->text, record->length
+            );
+        }
+        next->cursor += group;
+        count += group;
+    }
+
+    if (count > 0) {
+        fflush(stdout);
+        if (file) fflush(file);
+    }
+    file_unlock(async->logger, written);
+    for (struct shard_s* shard = shards; shard; shard = shard->next)
+        atomic_store(&shard->tail, shard->cursor);
+    return count;
+}
+
+static int flusher(void* argument) {
+    logger_async_t* async = argument;
+    while (true) {
+        const bool running = atomic_load(&async->running);
+        if (drain(async) > 0) continue;
+        if (!running) break;
+
+        mtx_lock(&async->lock);
+        atomic_store(&async->idle, true);
+        if (!pending(async) && atomic_load(&async->running)) {
+            struct timespec until;
+            timespec_get(&until, TIME_UTC);
+            until.tv_nsec += 10 * 1000 * 1000;
+            if (until.tv_nsec >= 1000 * 1000 * 1000) {
+                until.tv_sec++;
+                until.tv_nsec -= 1000 * 1000 * 1000;
+            }
+            cnd_timedwait(&async->wake, &async->lock, &until);
+        }
+        atomic_store(&async->idle, false);
+        mtx_unlock(&async->lock);
     }
+    return 0;
+}
+
+/**
+ * @brief Puts the formatted line of a message in the shard of the thread.
+ */
+static bool enqueue(
+    logger_t* logger, const logger_significance_t sign, const uint64_t stamp,
+    const char* line, const size_t length, const size_t stdout_offset
+) {
+    logger_async_t* async = logger->async;
+    struct shard_s* shard = shard_of(async);
+    size_t pos;
+    if (!shard || !reserve(async, shard, sign, 1, &pos)) return false;
+
+    struct record_s* record = record_at(async, shard, pos);
+    record->stamp = stamp;
+    record->group = 1;
+    record_copy(record, line, length, stdout_offset);
+    record->print_out = get_name(sign, logger).print_out;
+    record->to_file = true;
+
+    atomic_store(&shard->head, pos + 1);
+    wake_flusher(async);
+    return true;
+}
 
-    const size_t archived_path_size = strlen(file_path) +
-        strlen(meta) + 6;
-    char* archived_path = malloc(archived_path_size);
-    if (!superior_path(archived_path, file_path)) {
-        fclose(file_path);
+/**
+ * @brief Puts a sequence of lines in consecutive records of the shard of the thread.
+ *
+ * The first record opens the sequence in the file, the last closes it.
+ * All records are one group, so no other message is written in between.
+ */
+static bool enqueue_sequence(
+    logger_t* logger, const logger_significance_t sign, const uint64_t stamp,
+    const char* header, const size_t header_length,
+    char** messages, const size_t message_count
+) {
+    logger_async_t* async = logger->async;
+    const bool print_out = get_name(sign, logger).print_out;
+    struct shard_s* shard = shard_of(async);
+    size_t pos;
+    if (!shard || !reserve(async, shard, sign, message_count + 2, &pos))
         return false;
+
+    struct record_s* record = record_at(async, shard, pos);
+    record->stamp = stamp;
+    record->group = message_count + 2;
+    record_copy(record, header, header_length, header_length);
+    record->print_out = false;
+    record->to_file = true;
+
+    for (size_t i = 0; i < message_count; i++) {
+        record = record_at(async, shard, pos + i + 1);
+        record_line(record, "     ", 5, messages[i], 5);
+        record->print_out = print_out;
+        record->to_file = true;
     }
-    strcat(archived_path, "/logs");
-    make_dir(archived_path);
 
-    replace_unknown_chars(meta);
-    strcat(meta, ".log");
-    sprintf(archived_path, "%s/%s", archived_path, meta);
+    record = record_at(async, shard, pos + message_count + 1);
+    record_copy(record, "]\n", 2, 1);
+    record->print_out = print_out;
+    record->to_file = true;
 
-    if (!fcopy(old_file, archived_path)) {
-        fprintf(stderr, "File %s can't be copied.\n", file_path);
-        fclose(old_file);
+    atomic_store(&shard->head, pos + message_count + 2);
+    wake_flusher(async);
+    return true;
+}
+
+/**
+ * @brief Puts a batch of lines in consecutive records of the shard of the thread.
+ *
+ * Every message gets its own line with the same header.
+ * All records are one group, so no other message is written in between.
+ */
+static bool enqueue_batch(
+    logger_t* logger, const logger_significance_t sign, const uint64_t stamp,
+    const char* header, const size_t header_length,
+    const char* const* messages, const size_t message_count
+) {
+    logger_async_t* async = logger->async;
+    const bool print_out = get_name(sign, logger).print_out;
+    struct shard_s* shard = shard_of(async);
+    size_t pos;
+    if (!shard || !reserve(async, shard, sign, message_count, &pos))
         return false;
+
+    for (size_t i = 0; i < message_count; i++) {
+        struct record_s* record = record_at(async, shard, pos + i);
+        record->stamp = stamp;
+        record->group = i == 0 ? message_count : 1;
+        record_line(
+            record, header, header_length, messages[i], header_length
+        );
+        record->print_out = print_out;
+        record->to_file = true;
     }
-    fclose(old_file);
-    bool result = true;
-    if (can_access(file_path)) result = remove(file_path);
-    return result;
+
+    atomic_store(&shard->head, pos + message_count);
+    wake_flusher(async);
+    return true;
 }
 
 
 
-static void compute_time_stamp(
-    const char* log_path, unsigned long long* stamp_buffer
-) {
-    size_t start;
-    for (start = strlen(log_path); start > 0; start--)
-        if (log_path[start - 1] == '/' ||
-            log_path[start - 1] == '\\'
-        ) break;
+/**
+ * @brief Per thread buffers the lines of messages are formatted in.
+ *
+ * The data holds formatted text and the vectors hold the pieces of
+ * batched writes. Both only grow, so after the first messages of a
+ * thread writing a line does not allocate anymore.
+ * The buffers are freed when the thread exits.
+ */
+static thread_local struct scratch_s {
+    char* data;
+    size_t size;
+    io_vector_t* vectors;
+    size_t vector_count;
+} scratch = { NULL, 0, NULL, 0 };
+
+static tss_t scratch_key;
+static once_flag scratch_once = ONCE_FLAG_INIT;
+
+static void scratch_del(void* buffers) {
+    struct scratch_s* thread_scratch = buffers;
+    free(thread_scratch->data);
+    free(thread_scratch->vectors);
+}
 
-    size_t end;
-    for (end = strlen(log_path); end > 0; end--)
-        if (log_path[end - 1] == '_') break;
+static void scratch_key_create(void) {
+    tss_create(&scratch_key, scratch_del);
+}
 
-    if (end <= start) {
-        fprintf(stderr, "Error: end_index <= start_index.\n");
-        return;
+static char* scratch_reserve(const size_t size) {
+    if (size <= scratch.size) return scratch.data;
+
+    size_t new_size = scratch.size ? scratch.size : 1024;
+    while (new_size < size) new_size <<= 1;
+
+    char* data = realloc(scratch.data, new_size);
+    if (!data) {
+        perror("Failed to grow the logger scratch buffer");
+        return NULL;
     }
+    call_once(&scratch_once, scratch_key_create);
+    tss_set(scratch_key, &scratch);
 
-    char* file_name = malloc(end - start + 1);
-    strncpy(file_name, log_path + start, end - start);
-    file_name[end - start] = '\0';
+    scratch.data = data;
+    scratch.size = new_size;
+    return data;
+}
 
-    struct tm* time = time_of_str(file_name);
-    if (!time) {
-        free(file_name);
-        free(time);
-        fprintf(stderr, "An error occurred while parsing the time.\n");
-        return;
+/**
+ * @brief Sums the sizes of the pieces.
+ */
+static size_t vectors_size(const io_vector_t* vectors, const size_t count) {
+    size_t size = 0;
+    for (size_t i = 0; i < count; i++) size += vectors[i].size;
+    return size;
+}
+
+static io_vector_t* vectors_reserve(const size_t count) {
+    if (count <= scratch.vector_count) return scratch.vectors;
+
+    size_t new_count = scratch.vector_count ? scratch.vector_count : 64;
+    while (new_count < count) new_count <<= 1;
+
+    io_vector_t* vectors = realloc(
+        scratch.vectors, new_count * sizeof(io_vector_t)
+    );
+    if (!vectors) {
+        perror("Failed to grow the logger vectors");
+        return NULL;
+    }
+    call_once(&scratch_once, scratch_key_create);
+    tss_set(scratch_key, &scratch);
+
+    scratch.vectors = vectors;
+    scratch.vector_count = new_count;
+    return vectors;
+}
+
+/**
+ * @brief Writes the start of a line to the scratch buffer, its meta and significance.
+ *
+ * The meta is the cached wall-clock time, the monotonic stamp
+ * in seconds and the name of the logger.
+ * Returns the length of the header or a negative value on failure.
+ */
+static int header(
+    logger_t* logger, const logger_significance_t sign,
+    const uint64_t stamp, const char* opening
+) {
+    const char* wall = timestamp_wall(NULL);
+    if (!wall) {
+        perror("Time cannot be initialized");
+        return -1;
     }
-    const unsigned long long time_stamp =
-        time->tm_year * pow(10, 10) +
-        time->tm_mon * pow(10, 8) +
-        time->tm_mday * pow(10, 6) +
-        time->tm_hour * pow(10, 4) +
-        time->tm_min * pow(10, 2) +
-        time->tm_sec;
-    free(time);
 
-    *stamp_buffer = time_stamp;
+    const char* name = get_name(sign, logger).name;
+    while (true) {
+        const int length = snprintf(
+            scratch.data, scratch.size, "(%s, %llu.%09llu, %s)  %s  %s",
+            wall,
+            (unsigned long long)(stamp / 1000000000ULL),
+            (unsigned long long)(stamp % 1000000000ULL),
+            logger->name, name, opening
+        );
+        if (length < 0) return -1;
+        if ((size_t)length < scratch.size) return length;
+        if (!scratch_reserve(length + 1)) return -1;
+    }
+}
+
+/**
+ * @brief Writes a line to the stdout and file targets or the ring buffer.
+ */
+static bool emit(
+    logger_t* logger, const logger_significance_t sign, const uint64_t stamp,
+    const char* line, const size_t length, const size_t stdout_offset
+) {
+    if (logger->async)
+        return enqueue(logger, sign, stamp, line, length, stdout_offset);
+
+    if (get_name(sign, logger).print_out) fwrite(
+        line + stdout_offset, sizeof(char),
+        length - stdout_offset, stdout
+    );
+    FILE* file = file_lock(logger);
+    const size_t written = file ? file_put(logger, file, line, length) : 0;
+    file_unlock(logger, written);
+    return true;
 }
 
 
@@ -213,36 +952,23 @@ logger_t* logger_create(
     const char* name, const bool verbose,
     const bool print_stdout, const logger_callback_t log_func
 ) {
-
-    time_t raw_time;
-    time(&raw_time);
-    const struct tm* time_info = localtime(&raw_time);
-    if (!time_info) {
-        perror("Can't create logger. Can't get the local time");
-        return NULL;
-    }
-
     logger_t* logger = malloc(sizeof(logger_t));
     if (!logger) {
         perror("Failed to create logger");
         return NULL;
     }
 
-    logger->time = malloc(sizeof(struct tm));
-    if (!logger->time) {
-        perror("Failed to create logger time");
-        free(logger);
-        return NULL;
-    }
-
-    *logger->time = *time_info;
     *logger = (logger_t) {
         .name = name,
         .verbose = verbose,
         .print_out = print_stdout,
+        .level = info,
         .log = log_func,
         .own_file = false,
-        .file = NULL
+        .file = NULL,
+        .async = NULL,
+        .binary = NULL,
+        .rotation = NULL
     };
 
     return logger;
@@ -256,265 +982,577 @@ void logger_add_file(logger_t* logger, FILE* file) {
 void logger_mk_file(
     logger_t* logger, const bool named, const char* dir_path
 ) {
-    const char* unnamed = "latest";
-    char* name = strdup(unnamed);
-    if (named) name = str_to_lower(logger->name);
-
-    strcat(name, ".log");
-    char* path = malloc(strlen(dir_path) + strlen(name) + 1);
-    sprintf(path, "%s/%s", dir_path, name);
-
-    bool success = false;
-    if (can_access(path)) success = archive(path);
-    else success = true;
+    // The paths are zeroed, so they start empty.
+    logger_rotation_t* rotation = calloc(1, sizeof(logger_rotation_t));
+    if (!rotation) {
+        perror("Failed to create log file");
+        return;
+    }
 
-    if (!success && !remove(path)) {
-        if (!named) logger_mk_file(logger, true, dir_path);
+    const char* name = named ? logger->name : "latest";
+    const size_t name_length = strlen(name);
+    path_t* path = &rotation->path;
+    bool result = path_set(path, dir_path) && path_join(path, name);
+    if (result) {
+        char* file_name = path_str(path) + path->length - name_length;
+        str_lower(file_name, name_length + 1, file_name);
+    }
+    result = result && path_append(path, ".log", 4) &&
+        path_set(&rotation->archive_dir, dir_path) &&
+        path_join(&rotation->archive_dir, "logs");
+    if (!result) perror("Failed to create log file");
+
+    const char* file_path = path_str(path);
+    if (!result || (can_access(file_path) && !archive(
+        file_path, path_str(&rotation->archive_dir), logger->name
+    ) && remove(file_path) != 0) ||
+        mtx_init(&rotation->lock, mtx_plain) != thrd_success
+    ) {
+        path_release(&rotation->path);
+        path_release(&rotation->archive_dir);
+        free(rotation);
+        if (result && !named) logger_mk_file(logger, true, dir_path);
         return;
     }
+    logger->rotation = rotation;
     logger->own_file = true;
-    logger->file = fopen(path, "a");
-    logger->log(logger, info, "Logger mounted to file.");
+    logger->file = rotation_open(rotation, logger->name);
+    logger_log(logger, info, "Logger mounted to file.");
 }
 
-bool logger_write(
-    logger_t* logger, const logger_significance_t sign,
-    const char* format, ...
+bool logger_mk_rotation(
+    logger_t* logger, const size_t max_bytes, const uint64_t max_age
 ) {
-    bool found_arg = false;
-    for (size_t i = 0; i < strlen(format); i++)
-        if (format[i] == '%') found_arg = true;
+    logger_rotation_t* rotation = logger->rotation;
+    if (!rotation) return logger_log(logger, error,
+        "Logger %s has no own file to rotate.", logger->name
+    );
 
-    char* msg;
+    mtx_lock(&rotation->lock);
+    rotation->max_bytes = max_bytes;
+    rotation->max_age = max_age * 1000000000ULL;
+    mtx_unlock(&rotation->lock);
+    return true;
+}
 
-    if (found_arg) {
-        va_list args;
-        va_start(args, format);
-        #if _WIN32
-        const int size = _vscprintf(format, args);
-        #else
-        const int size = vsnprintf(NULL, 0, format, args);
-        #endif
+bool logger_mk_segments(logger_t* logger, const size_t segment_size) {
+    logger_rotation_t* rotation = logger->rotation;
+    if (!rotation || !logger->file) return logger_log(logger, error,
+        "Logger %s has no own file to map.", logger->name
+    );
 
-        va_end(args);
+    mtx_lock(&rotation->lock);
+    bool result = true;
+    if (!rotation->segment) {
+        const size_t granularity = segment_granularity();
+        rotation->segment = segment_size < granularity ? granularity :
+            (segment_size + granularity - 1) / granularity * granularity;
+        result = segment_open(rotation, logger->file);
+        if (!result) rotation->segment = 0;
+    }
+    mtx_unlock(&rotation->lock);
+    return result;
+}
 
-        if (size < 0) return NULL;
+bool logger_mk_async(
+    logger_t* logger, const size_t capacity, const logger_overflow_t overflow
+) {
+    if (logger->async) return true;
 
-        msg = malloc(size + 1);
-        if (!msg) return NULL;
+    size_t size = 2;
+    while (size < capacity) size <<= 1;
 
-        va_start(args, format);
-        vsnprintf(msg, size + 1, format, args);
-        va_end(args);
+    logger_async_t* async = malloc(sizeof(logger_async_t));
+    if (!async) {
+        perror("Failed to create asynchronous logger");
+        return false;
     }
-    else msg = strdup(format);
 
-    char* meta = malloc(strlen(logger->name) + 24);
-    time_t raw_time;
-    time(&raw_time);
-    struct tm* time = localtime(&raw_time);
-    if (!time) {
-        perror("Time cannot be initialized");
-        free(msg);
-        free(meta);
+    async->id = atomic_fetch_add(&async_ids, 1);
+    async->mask = size - 1;
+    async->overflow = overflow;
+    async->logger = logger;
+    atomic_init(&async->shards, NULL);
+    atomic_init(&async->running, true);
+    atomic_init(&async->idle, false);
+
+    if (mtx_init(&async->lock, mtx_plain) != thrd_success) {
+        free(async);
         return false;
     }
-    if (!str_of_time(time, meta)) {
-        perror("Time cannot be converted to valid string");
-        free(msg);
-        free(meta);
+    if (cnd_init(&async->wake) != thrd_success) {
+        mtx_destroy(&async->lock);
+        free(async);
         return false;
     }
-    sprintf(meta, "%s, %s", meta, logger->name);
-    if (logger->time) free(logger->time);
-    logger->time = malloc(sizeof(struct tm));
-    if (!logger->time) {
-        perror("Allocation of logger time failed");
-        free(msg);
-        free(meta);
-        return false;
+    if (thrd_create(&async->flusher, flusher, async) != thrd_success) {
+        cnd_destroy(&async->wake);
+        mtx_destroy(&async->lock);
+        free(async);
+        return logger_log(logger, error,
+            "Flusher thread of logger %s cannot be started.", logger->name
+        );
     }
-    *logger->time = *time;
 
-    if (get_name(sign, logger).print_out) printf("%s\n", msg);
+    logger->async = async;
+    return true;
+}
 
-    if (!logger->file) {
-        free(msg);
-        free(meta);
-        return sign != error;
+bool logger_flush(logger_t* logger) {
+    logger_async_t* async = logger->async;
+    if (!async) {
+        fflush(stdout);
+        FILE* file = file_lock(logger);
+        bool result = !file || fflush(file) == 0;
+        if (file && logger->rotation && logger->rotation->map)
+            result = segment_sync(
+                logger->rotation->map, logger->rotation->cursor
+            ) && result;
+        file_unlock(logger, 0);
+        return result;
     }
 
-    char* final_msg = malloc(
-        strlen(msg) + strlen(logger->name) +
-        strlen(get_name(sign, logger).name) + 30
-    );
-    sprintf(
-        final_msg, "(%s)  %s  %s\n",
-        meta, get_name(sign, logger).name, msg
-    );
-    fwrite(
-        final_msg, sizeof(char),
-        strlen(final_msg), logger->file
+    for (struct shard_s* shard = atomic_load(&async->shards);
+        shard; shard = shard->next
+    ) {
+        const size_t target = atomic_load(&shard->head);
+        while (atomic_load(&shard->tail) < target) {
+            wake_flusher(async);
+            thrd_yield();
+        }
+    }
+
+    bool result = true;
+    FILE* file = file_lock(logger);
+    if (file && logger->rotation && logger->rotation->map)
+        result = segment_sync(
+            logger->rotation->map, logger->rotation->cursor
+        );
+    file_unlock(logger, 0);
+    return result;
+}
+
+bool logger_enabled(
+    const logger_t* logger, const logger_significance_t sign
+) {
+    if (sign > logger->level) return false;
+    if (logger->log != logger_write) return true;
+    return logger->file || logger->binary || get_name(sign, logger).print_out;
+}
+
+bool logger_write(
+    logger_t* logger, const logger_significance_t sign,
+    const char* format, ...
+) {
+    if (!logger_enabled(logger, sign)) return sign != error;
+    const uint64_t stamp = timestamp_mono();
+    va_list args;
+    if (logger->binary) {
+        va_start(args, format);
+        const bool recorded = binary_log_write(
+            logger->binary, sign, stamp, format, args
+        );
+        va_end(args);
+        if (!logger->file && !get_name(sign, logger).print_out)
+            return recorded && sign != error;
+    }
+
+    if (!scratch_reserve(1024)) return false;
+    const int offset = header(logger, sign, stamp, "");
+    if (offset < 0) return false;
+
+    va_start(args, format);
+    const int size = vsnprintf(
+        scratch.data + offset, scratch.size - offset, format, args
     );
+    va_end(args);
+    if (size < 0) return false;
+
+    const size_t length = offset + size + 1;
+    if (length > scratch.size) {
+        if (!scratch_reserve(length + 1)) return false;
+        va_start(args, format);
+        vsnprintf(scratch.data + offset, scratch.size - offset, format, args);
+        va_end(args);
+    }
+    scratch.data[length - 1] = '\n';
 
-    free(meta);
-    free(msg);
-    free(final_msg);
-    return sign != error;
+    return emit(logger, sign, stamp, scratch.data, length, offset) &&
+        sign != error;
 }
 
 bool logger_write_sequence(
     logger_t* logger, const logger_significance_t sign,
     char** messages, const size_t message_count
 ) {
+    if (!logger_enabled(logger, sign)) return sign != error;
 
-    size_t msg_size = 0;
-    for (size_t i = 0; i < message_count; i++) {
-        msg_size += strlen(messages[i]);
-        msg_size += 6;
+    const uint64_t stamp = timestamp_mono();
+    if (logger->binary) {
+        const bool recorded = binary_log_write_sequence(
+            logger->binary, sign, stamp, messages, message_count
+        );
+        if (!logger->file && !get_name(sign, logger).print_out)
+            return recorded;
     }
 
-    char* stdout_msg = malloc(msg_size + 1);
-    stdout_msg[0] = '\0';
-    char* msg = malloc(msg_size + 1);
-    msg[0] = '\0';
+    if (!scratch_reserve(1024)) return false;
+    const int offset = header(logger, sign, stamp, "[\n");
+    if (offset < 0) return false;
+
+    if (logger->async) {
+        if (message_count + 2 <= logger->async->mask + 1) return
+            enqueue_sequence(
+                logger, sign, stamp, scratch.data, offset,
+                messages, message_count
+            );
+        logger_flush(logger);
+    }
+
+    // The pieces of the file text are followed by the pieces of the
+    // stdout text, the messages themselves are never copied.
+    io_vector_t* vectors = vectors_reserve(message_count * 5 + 3);
+    if (!vectors) return false;
+
+    io_vector_t* file_vectors = vectors;
+    io_vector_t* stdout_vectors = vectors + message_count * 3 + 2;
+    file_vectors[0] = (io_vector_t) { scratch.data, offset };
     for (size_t i = 0; i < message_count; i++) {
-        strcat(msg, "     ");
-        strcat(msg, messages[i]);
-        strcat(msg, "\n");
-        strcat(stdout_msg, messages[i]);
-        strcat(stdout_msg, "\n");
-    }
-
-    char* meta = malloc(strlen(logger->name) + 24);
-    time_t raw_time;
-    time(&raw_time);
-    struct tm* time = localtime(&raw_time);
-    if (!time) {
-        perror("Time cannot be initialized");
-        free(msg);
-        free(stdout_msg);
-        free(meta);
-        return false;
+        const size_t message_length = strlen(messages[i]);
+        file_vectors[i * 3 + 1] = (io_vector_t) { "     ", 5 };
+        file_vectors[i * 3 + 2] = (io_vector_t) { messages[i], message_length };
+        file_vectors[i * 3 + 3] = (io_vector_t) { "\n", 1 };
+        stdout_vectors[i * 2] = (io_vector_t) { messages[i], message_length };
+        stdout_vectors[i * 2 + 1] = (io_vector_t) { "\n", 1 };
     }
-    if (!str_of_time(time, meta)) {
-        perror("Time cannot be converted to valid string");
-        free(msg);
-        free(stdout_msg);
-        free(meta);
-        return false;
+    file_vectors[message_count * 3 + 1] = (io_vector_t) { "]\n", 2 };
+    stdout_vectors[message_count * 2] = (io_vector_t) { "\n", 1 };
+
+    bool result = true;
+    if (get_name(sign, logger).print_out) result = fwrite_vectored(
+        stdout, stdout_vectors, message_count * 2 + 1
+    );
+    FILE* file = file_lock(logger);
+    size_t written = 0;
+    if (file) {
+        const size_t size = vectors_size(file_vectors, message_count * 3 + 2);
+        written = file_put_vectored(
+            logger, file, file_vectors, message_count * 3 + 2
+        );
+        result = written == size && result;
     }
-    sprintf(meta, "%s, %s", meta, logger->name);
-    if (logger->time) free(logger->time);
-    logger->time = malloc(sizeof(struct tm));
-    if (!logger->time) {
-        perror("Allocation of logger time failed");
-        free(msg);
-        free(stdout_msg);
-        free(meta);
-        return false;
+    file_unlock(logger, written);
+    return result;
+}
+
+bool logger_write_batch(
+    logger_t* logger, const logger_significance_t sign,
+    const char* const* messages, const size_t message_count
+) {
+    if (message_count == 0) return true;
+    if (!logger_enabled(logger, sign)) return sign != error;
+
+    const uint64_t stamp = timestamp_mono();
+    if (logger->binary) {
+        const bool recorded = binary_log_write_batch(
+            logger->binary, sign, stamp, messages, message_count
+        );
+        if (!logger->file && !get_name(sign, logger).print_out)
+            return recorded && sign != error;
+    }
+
+    if (!scratch_reserve(1024)) return false;
+    const int offset = header(logger, sign, stamp, "");
+    if (offset < 0) return false;
+
+    if (logger->async) {
+        if (message_count <= logger->async->mask + 1) return
+            enqueue_batch(
+                logger, sign, stamp, scratch.data, offset,
+                messages, message_count
+            ) && sign != error;
+        logger_flush(logger);
     }
-    *logger->time = *time;
 
-    if (get_name(sign, logger).print_out) printf("%s\n", stdout_msg);
+    // Every line is the shared header, the message and a line break,
+    // stdout gets the same pieces without the header.
+    io_vector_t* vectors = vectors_reserve(message_count * 5);
+    if (!vectors) return false;
 
-    if (!logger->file) {
-        free(msg);
-        free(stdout_msg);
-        free(meta);
-        return sign != error;
+    io_vector_t* stdout_vectors = vectors + message_count * 3;
+    for (size_t i = 0; i < message_count; i++) {
+        const io_vector_t message = { messages[i], strlen(messages[i]) };
+        vectors[i * 3] = (io_vector_t) { scratch.data, offset };
+        vectors[i * 3 + 1] = message;
+        vectors[i * 3 + 2] = (io_vector_t) { "\n", 1 };
+        stdout_vectors[i * 2] = message;
+        stdout_vectors[i * 2 + 1] = (io_vector_t) { "\n", 1 };
     }
 
-    char* final_msg = malloc(
-        strlen(msg) + strlen(logger->name) +
-        strlen(get_name(sign, logger).name) + 33
-    );
-    sprintf(
-        final_msg, "(%s)  %s  [\n%s]\n",
-        meta, get_name(sign, logger).name, msg
-    );
-    fwrite(
-        final_msg, sizeof(char),
-        strlen(final_msg), logger->file
+    bool result = true;
+    if (get_name(sign, logger).print_out) result = fwrite_vectored(
+        stdout, stdout_vectors, message_count * 2
     );
-
-    free(meta);
-    free(msg);
-    free(stdout_msg);
-    free(final_msg);
-    return true;
+    FILE* file = file_lock(logger);
+    size_t written = 0;
+    if (file) {
+        const size_t size = vectors_size(vectors, message_count * 3);
+        written = file_put_vectored(logger, file, vectors, message_count * 3);
+        result = written == size && result;
+    }
+    file_unlock(logger, written);
+    return result && sign != error;
 }
 
-void logger_clean_logs(
-    const char* log_dir_path, const int max_log_files
+/**
+ * @brief A log file found by the retention.
+ *
+ * The name is an offset into the names of the scan,
+ * the modification time is in nanoseconds since the epoch.
+ */
+struct retained_s {
+    int64_t modified;
+    uint64_t size;
+    size_t name;
+};
+
+/**
+ * @brief The logs of a directory, read in a single pass.
+ */
+struct retention_scan_s {
+    const char* path;
+    void* dir;
+    struct retained_s* logs;
+    size_t count;
+    size_t capacity;
+    char* names;
+    size_t names_size;
+    size_t names_capacity;
+};
+
+static bool retention_add(
+    struct retention_scan_s* scan, const char* name,
+    const int64_t modified, const uint64_t size
 ) {
-    char** files = NULL;
-    const int file_count = list_files(
-        log_dir_path, &files
-    );
-    if (!files) {
-        if (file_count == 0) return;
-        perror("Error while reading files of log directory");
-        return;
-    }
+    const size_t length = strlen(name);
+    if (length < 4 || strcmp(name + length - 4, ".log") != 0) return true;
 
-    if (max_log_files >= file_count) {
-        for (int i = 0; i < file_count; i++) free(files[i]);
-        free(files);
-        return;
+    if (scan->count == scan->capacity) {
+        const size_t capacity = scan->capacity ? scan->capacity * 2 : 64;
+        struct retained_s* logs = realloc(
+            scan->logs, capacity * sizeof(struct retained_s)
+        );
+        if (!logs) return false;
+        scan->logs = logs;
+        scan->capacity = capacity;
+    }
+    if (scan->names_size + length + 1 > scan->names_capacity) {
+        size_t capacity = scan->names_capacity ? scan->names_capacity : 4096;
+        while (capacity < scan->names_size + length + 1) capacity *= 2;
+        char* names = realloc(scan->names, capacity);
+        if (!names) return false;
+        scan->names = names;
+        scan->names_capacity = capacity;
     }
 
-    struct log_s {
-        unsigned long long time_stamp;
-        char* name;
-        bool deletable;
-    }* logs = malloc(file_count * sizeof(struct log_s));
+    memcpy(scan->names + scan->names_size, name, length + 1);
+    scan->logs[scan->count++] = (struct retained_s) {
+        .modified = modified,
+        .size = size,
+        .name = scan->names_size
+    };
+    scan->names_size += length + 1;
+    return true;
+}
 
-    if (!logs) {
-        perror("Error while allocation of logs list");
-        return;
-    }
+static int retained_newer(const void* first, const void* second) {
+    const int64_t a = ((const struct retained_s*)first)->modified;
+    const int64_t b = ((const struct retained_s*)second)->modified;
+    return (a < b) - (a > b);
+}
 
-    for (int i = 0; i < file_count; i++) {
-        logs[i].deletable = false;
-        logs[i].name = malloc(sizeof(char) * (
-            strlen(files[i]) + strlen(log_dir_path) + 2
-        ));
 
-        if (!logs[i].name) {
-            perror("Error while allocation of log name");
-            free(logs);
-            return;
-        }
-        sprintf(logs[i].name, "%s/%s", log_dir_path, files[i]);
 
-        compute_time_stamp(files[i], &logs[i].time_stamp);
-        if (files[i]) free(files[i]);
+#ifdef _WIN32
+#include <windows.h>
 
-        if (i != 0 && i < file_count - i) {
-            const size_t prev = i - 1;
-            if (logs[prev].time_stamp < logs[i].time_stamp) {
-                logs[prev].deletable = true;
-            }
-        }
+static bool retention_scan(struct retention_scan_s* scan) {
+    WIN32_FIND_DATA found;
+    path_t search_path = { 0 };
+    const HANDLE find = path_set(&search_path, scan->path) &&
+        path_join(&search_path, "*") ?
+        FindFirstFile(path_str(&search_path), &found) : INVALID_HANDLE_VALUE;
+    path_release(&search_path);
+    if (find == INVALID_HANDLE_VALUE) return false;
+
+    bool result = true;
+    do {
+        if (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+        const uint64_t ticks = (uint64_t)found.ftLastWriteTime.dwHighDateTime << 32 |
+            found.ftLastWriteTime.dwLowDateTime;
+        const uint64_t size = (uint64_t)found.nFileSizeHigh << 32 |
+            found.nFileSizeLow;
+        result = retention_add(
+            scan, found.cFileName,
+            (int64_t)(ticks - 116444736000000000ULL) * 100, size
+        );
+    } while (result && FindNextFile(find, &found));
+
+    FindClose(find);
+    return result;
+}
+
+static bool retention_remove(struct retention_scan_s* scan, const char* name) {
+    path_t path = { 0 };
+    const bool result = path_set(&path, scan->path) && path_join(&path, name) &&
+        DeleteFile(path_str(&path));
+    path_release(&path);
+    return result;
+}
+
+static void retention_close(struct retention_scan_s* scan) {
+    (void)scan;
+}
+
+
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * @brief Gets the modification time of the file in nanoseconds since the epoch.
+ */
+static int64_t modified_of(const struct stat* attributes) {
+#ifdef __APPLE__
+    const struct timespec modified = attributes->st_mtimespec;
+#else
+    const struct timespec modified = attributes->st_mtim;
+#endif
+    return (int64_t)modified.tv_sec * 1000000000LL + modified.tv_nsec;
+}
+
+static bool retention_scan(struct retention_scan_s* scan) {
+    DIR* dir = opendir(scan->path);
+    if (!dir) return false;
+    scan->dir = dir;
+
+    const int fd = dirfd(dir);
+    struct dirent* entity;
+    while ((entity = readdir(dir)) != NULL) {
+        if (entity->d_type != DT_REG && entity->d_type != DT_UNKNOWN)
+            continue;
+
+        struct stat attributes;
+        if (fstatat(fd, entity->d_name, &attributes, AT_SYMLINK_NOFOLLOW) != 0 ||
+            !S_ISREG(attributes.st_mode)
+        ) continue;
+
+        if (!retention_add(
+            scan, entity->d_name, modified_of(&attributes), attributes.st_size
+        )) return false;
     }
+    return true;
+}
 
-    for (int i = 0; i < file_count; i++) {
-        if (!logs[i].deletable) free(logs[i].name);
-        else {
-            remove(logs[i].name);
-            free(logs[i].name);
-        }
+static bool retention_remove(struct retention_scan_s* scan, const char* name) {
+    return unlinkat(dirfd(scan->dir), name, 0) == 0;
+}
+
+static void retention_close(struct retention_scan_s* scan) {
+    if (scan->dir) closedir(scan->dir);
+}
+
+#endif
+
+
+
+int logger_retain_logs(
+    const char* log_dir_path, const logger_retention_t retention
+) {
+    struct retention_scan_s scan = { .path = log_dir_path };
+    if (!retention_scan(&scan)) {
+        if (scan.dir || errno != ENOENT)
+            perror("Error while reading files of log directory");
+        retention_close(&scan);
+        free(scan.logs);
+        free(scan.names);
+        return -1;
+    }
+    qsort(scan.logs, scan.count, sizeof(struct retained_s), retained_newer);
+
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    const int64_t oldest = (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec -
+        (int64_t)retention.max_age * 1000000000LL;
+
+    // The newest logs are kept as long as all of them fit in the budgets.
+    int removed = 0;
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < scan.count; i++) {
+        const struct retained_s* log = &scan.logs[i];
+        bytes += log->size;
+        if ((!retention.max_files || i < retention.max_files) &&
+            (!retention.max_bytes || bytes <= retention.max_bytes) &&
+            (!retention.max_age || log->modified >= oldest)
+        ) continue;
+
+        if (retention_remove(&scan, scan.names + log->name)) removed++;
+        else perror("Log file cannot be removed");
     }
-    free(files);
+
+    retention_close(&scan);
+    free(scan.logs);
+    free(scan.names);
+    return removed;
+}
+
+void logger_clean_logs(
+    const char* log_dir_path, const int max_log_files
+) {
+    logger_retain_logs(log_dir_path, (logger_retention_t) {
+        .max_files = max_log_files > 0 ? max_log_files : 0
+    });
 }
 
 
 
 void logger_del(logger_t* logger) {
     if (!logger) return;
-    if (!logger->time) free(logger->time);
-    logger->log(logger, info, "Disposal of logger %s.", logger->name);
+    logger_log(logger, info, "Disposal of logger %s.", logger->name);
+    if (logger->async) {
+        logger_async_t* async = logger->async;
+        atomic_store(&async->running, false);
+        mtx_lock(&async->lock);
+        cnd_signal(&async->wake);
+        mtx_unlock(&async->lock);
+        thrd_join(async->flusher, NULL);
+        cnd_destroy(&async->wake);
+        mtx_destroy(&async->lock);
+
+        struct shard_s* shard = atomic_load(&async->shards);
+        while (shard) {
+            struct shard_s* next = shard->next;
+            free(shard->records);
+            free(shard);
+            shard = next;
+        }
+        free(async);
+        logger->async = NULL;
+    }
+    if (logger->binary) {
+        binary_log_del(logger->binary);
+        logger->binary = NULL;
+    }
+    if (logger->file && logger->rotation)
+        segment_close(logger->rotation, logger->file);
     if (logger->file && logger->own_file) fclose(logger->file);
+    if (logger->rotation) {
+        mtx_destroy(&logger->rotation->lock);
+        path_release(&logger->rotation->path);
+        path_release(&logger->rotation->archive_dir);
+        free(logger->rotation);
+        logger->rotation = NULL;
+    }
     logger = NULL;
 }
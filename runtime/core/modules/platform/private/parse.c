@@ -15,31 +15,132 @@
 //    A commercial license will be available at a later time for use in commercial products.
 
 #include "parse.h"
+#include "arena.h"
+#include "common.h"
+#include "str.h"
+#include <stdalign.h>
 #include <yaml.h>
 
 
+/**
+ * @brief Maps deeper than this are not indexed, which also ends maps that contain themselves.
+ */
+#define PARSE_INDEX_DEPTH 64
+
+/**
+ * @brief The index of a single entries array.
+ *
+ * The slots are an open addressing table of entry indices plus one,
+ * the tables of the maps are at the index of their entry.
+ */
+struct table_s {
+    parse_entry_t* entries;
+    size_t length;
+    uint32_t mask;
+    struct slot_s {
+        uint32_t hash;
+        uint32_t entry;
+    }* slots;
+    struct table_s** maps;
+};
+
+struct parse_index_s {
+    arena_t* arena;
+    struct table_s* root;
+};
+
 /**
  * @brief Representation of the state superordinate of the iterations through an entries array.
  *
- * The state consists of the entries array pointer,
- * the length of the array as size and the last token
- * the yaml parser should iterate to in the case of scanning.
+ * The state consists of the index of the entries array,
+ * the last token the yaml parser should iterate to
+ * in the case of scanning and the arena the values are allocated from.
  */
 typedef struct {
-    parse_entry_t* const entries;
+    const struct table_s* const table;
     const int level;
-    const size_t size;
     const yaml_token_type_t end;
+    arena_t* const arena;
 } parse_state_t;
 
+static uint32_t hash_key(const char* key, const size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)key[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Finds the entry of the key, the key needs no terminating zero.
+ *
+ * The table of the entry is set too, if it is a map.
+ */
 static parse_entry_t* get_entry(
-    const char* key,
-    parse_entry_t* const entries,
-    const size_t length
+    const struct table_s* table, const struct table_s** nested,
+    const char* key, const size_t length
 ) {
-    for (size_t i = 0; i < length; i++)
-        if (!strcmp(key, entries[i].key)) return &entries[i];
-    return NULL;
+    const uint32_t hash = hash_key(key, length);
+    for (uint32_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+        const struct slot_s* slot = &table->slots[i];
+        if (!slot->entry) return NULL;
+
+        parse_entry_t* entry = &table->entries[slot->entry - 1];
+        if (slot->hash == hash && strncmp(entry->key, key, length) == 0 &&
+            entry->key[length] == '\0'
+        ) {
+            *nested = table->maps[slot->entry - 1];
+            return entry;
+        }
+    }
+}
+
+static struct table_s* table_create(
+    arena_t* arena, parse_entry_t* entries, const size_t length, const int depth
+) {
+    uint32_t slot_count = 8;
+    while (slot_count < length * 2) slot_count *= 2;
+
+    struct table_s* table = arena_alloc(
+        arena, sizeof(struct table_s), alignof(struct table_s)
+    );
+    struct slot_s* slots = arena_alloc(
+        arena, slot_count * sizeof(struct slot_s), alignof(struct slot_s)
+    );
+    struct table_s** maps = arena_alloc(
+        arena, (length + 1) * sizeof(struct table_s*), alignof(struct table_s*)
+    );
+    if (!table || !slots || !maps) return NULL;
+    memset(slots, 0, slot_count * sizeof(struct slot_s));
+    *table = (struct table_s) {
+        .entries = entries,
+        .length = length,
+        .mask = slot_count - 1,
+        .slots = slots,
+        .maps = maps
+    };
+
+    for (size_t i = 0; i < length; i++) {
+        const struct table_s* nested;
+        const size_t key_length = strlen(entries[i].key);
+        maps[i] = NULL;
+        if (get_entry(table, &nested, entries[i].key, key_length)) continue;
+
+        const uint32_t hash = hash_key(entries[i].key, key_length);
+        uint32_t slot = hash & table->mask;
+        while (slots[slot].entry) slot = (slot + 1) & table->mask;
+        slots[slot] = (struct slot_s) { .hash = hash, .entry = i + 1 };
+
+        if (entries[i].type != map || !entries[i].buffer ||
+            depth >= PARSE_INDEX_DEPTH
+        ) continue;
+        maps[i] = table_create(
+            arena, entries[i].buffer, entries[i].size, depth + 1
+        );
+        if (!maps[i]) return NULL;
+    }
+    return table;
 }
 
 /**
@@ -52,51 +153,98 @@ static bool scan_recursive(
 );
 
 
+/**
+ * @brief Parses the whole value as decimal int.
+ *
+ * The digits are read directly, which is much faster than strtol() for
+ * the short numbers of long lists.
+ */
+static bool parse_integer(const char* value, int* result) {
+    const bool negative = *value == '-';
+    if (negative || *value == '+') value++;
+    if (*value < '0' || *value > '9') return false;
+
+    int64_t parsed_value = 0;
+    for (; *value >= '0' && *value <= '9'; value++) {
+        parsed_value = parsed_value * 10 + (*value - '0');
+        if (parsed_value > (int64_t)INT_MAX + 1) return false;
+    }
+    if (*value != '\0') return false;
+    if (negative) parsed_value = -parsed_value;
+    if (parsed_value > INT_MAX) return false;
+    *result = (int)parsed_value;
+    return true;
+}
+
+/**
+ * @brief Parses the whole value as double.
+ */
+static bool parse_floating(const char* value, double* result) {
+    char* end;
+    const double parsed_value = strtod(value, &end);
+    if (end == value || *end != '\0') return false;
+    *result = parsed_value;
+    return true;
+}
+
+/**
+ * @brief Tests if the type is one of the lists.
+ */
+static bool is_list(const enum parse_type_e type) {
+    return type == list || type == integer_list || type == floating_list;
+}
+
 /**
  * @brief Parses the scalar value string into the corresponding type and set the buffer of the entry by the key in the entries array.
  */
 static bool scalar(
     parse_entry_t* const entry,
     const char* value,
+    arena_t* arena,
     logger_t* logger
 ) {
     const char* format = "SCALAR  %s %s set for \"%s\".";
     if (entry->type == integer) {
-        const long parsed_value = strtol(value, NULL, 10);
-        if (parsed_value >= INT_MIN || INT_MAX >= parsed_value) {
-            int* finalValue = malloc(sizeof(int));
-            *finalValue = parsed_value;
-            entry->buffer = finalValue;
-            entry->size = sizeof(int);
-        }
-        return logger->log(
+        int* const value_ptr = arena_alloc(arena, sizeof(int), alignof(int));
+        if (!value_ptr || !parse_integer(value, value_ptr)) return logger_log(
+            logger, error, "SCALAR  %s is no int for \"%s\".", value, entry->key
+        );
+        entry->buffer = value_ptr;
+        entry->size = sizeof(int);
+        return logger_log(
            logger, info, format, "Int", value, entry->key
        );
     }
     
     if (entry->type == string) {
-        entry->size = sizeof(char) * strlen(value);
-        entry->buffer = strdup(value);
-        char* value_str = malloc(strlen(value) + 5);
-        sprintf(value_str, "\"%s\"", value);
-        logger->log(
-            logger, info, format, "String", value_str, entry->key
+        const size_t length = strlen(value);
+        char* const copy = arena_strndup(arena, value, length);
+        if (!copy) return logger_log(logger, error,
+            "SCALAR  String for \"%s\" cannot be allocated.", entry->key
+        );
+        entry->size = sizeof(char) * length;
+        entry->buffer = copy;
+        logger_log(
+            logger, info, "SCALAR  String \"%s\" set for \"%s\".",
+            value, entry->key
         );
-        free(value_str);
         return true;
     }
 
     if (entry->type == floating) {
-        double* const value_ptr = malloc(sizeof(double));
-        entry->size = sizeof(double);
-
-        *value_ptr = strtod(entry->key, NULL);
+        double* const value_ptr = arena_alloc(
+            arena, sizeof(double), alignof(double)
+        );
+        if (!value_ptr || !parse_floating(value, value_ptr)) return logger_log(
+            logger, error, "SCALAR  %s is no float for \"%s\".", value, entry->key
+        );
         entry->buffer = value_ptr;
-        return logger->log(
+        entry->size = sizeof(double);
+        return logger_log(
             logger, info, format, "Float", value, entry->key
         );
     }
-    return logger->log(
+    return logger_log(
         logger, error,
         "SCALAR  There is a scalar value instead of the awaited type. "
         "Make sure the placeholder got the right value -> %s: %s",
@@ -110,199 +258,1289 @@ static bool scalar(
  */
 static bool further_entries(
     const parse_entry_t* entry,
+    const struct table_s* table,
     const int last_level,
+    const yaml_token_type_t end,
     yaml_parser_t* parser,
+    arena_t* arena,
     logger_t* logger
 ) {
-    // The following will return true because there are
-    // at first no difference between a yaml block list and a block map.
-    // Therefore, the parser will always call the entries scan for block list.
-    if (entry->type != map) return true;
-    logger->log(logger, info,
+    logger_log(logger, info,
         "MAP  Start recursive scan for \"%s\"...", entry->key
     );
     const bool result = scan_recursive(parser,
         (parse_state_t) {
-            .entries = entry->buffer,
+            .table = table,
             .level = last_level + 1,
-            .size = entry->size,
-            .end = YAML_BLOCK_END_TOKEN
+            .end = end,
+            .arena = arena
         }, logger);
 
-    if (!result) return logger->log(logger, error,
+    if (!result) return logger_log(logger, error,
         "MAP  Recursive scan for key %s has failed.", entry->key
     );
 
-    return logger->log(logger, info,
+    return logger_log(logger, info,
         "MAP  Recursive scan for key %s is done.", entry->key
     );
 }
 
 
 /**
- * @brief Either, if the list already exists adds the value to it, or if not, a new array will be created with the value.
+ * @brief Gets room for one more element at the end of the list of the entry.
+ *
+ * Lists grow to the next power of two, starting at four elements, so their
+ * capacity is known from their size. The smaller arrays stay in the arena.
+ */
+static void* list_append(
+    parse_entry_t* entry, const size_t element_size, arena_t* arena
+) {
+    const size_t size = entry->buffer ? entry->size : 0;
+    if (size == 0 || (size >= 4 && (size & (size - 1)) == 0)) {
+        const size_t capacity = size ? size * 2 : 4;
+        void* elements = arena_alloc(arena, capacity * element_size, element_size);
+        if (!elements) return NULL;
+        if (size) memcpy(elements, entry->buffer, size * element_size);
+        entry->buffer = elements;
+    }
+    entry->size = size + 1;
+    return (char*)entry->buffer + size * element_size;
+}
+
+
+/**
+ * @brief Adds the value to the end of the list, decoded to the element type of the list.
  */
 static bool follow_list(
     parse_entry_t* entry,
     const char* value,
+    arena_t* arena,
     logger_t* logger
 ) {
-    if (entry->type != list) return logger->log(logger, error,
+    if (entry->type == list) {
+        char* const copy = arena_strndup(arena, value, strlen(value));
+        char** const element = copy ?
+            list_append(entry, sizeof(char*), arena) : NULL;
+        if (!element) return logger_log(logger, error,
+            "LIST  Value of %s cannot be allocated.", entry->key
+        );
+        *element = copy;
+    } else if (entry->type == integer_list) {
+        int parsed_value;
+        if (!parse_integer(value, &parsed_value)) return logger_log(logger, error,
+            "LIST  %s is no int for %s.", value, entry->key
+        );
+        int* const element = list_append(entry, sizeof(int), arena);
+        if (!element) return logger_log(logger, error,
+            "LIST  Value of %s cannot be allocated.", entry->key
+        );
+        *element = parsed_value;
+    } else if (entry->type == floating_list) {
+        double parsed_value;
+        if (!parse_floating(value, &parsed_value)) return logger_log(logger, error,
+            "LIST  %s is no float for %s.", value, entry->key
+        );
+        double* const element = list_append(entry, sizeof(double), arena);
+        if (!element) return logger_log(logger, error,
+            "LIST  Value of %s cannot be allocated.", entry->key
+        );
+        *element = parsed_value;
+    } else return logger_log(logger, error,
         "LIST  Wrong type for %s was found. Type list was awaited.", entry->key
     );
 
-    if (entry->buffer) {
-        entry->size++;
-        char** entries = realloc(
-            entry->buffer,
-            sizeof(char*) * entry->size + 1
-        );
+    return logger_log(logger, info,
+        "LIST  Added \"%s\" to %s", value, entry->key
+    );
+}
 
-        entries[entry->size - 1] = strdup(value);
-        entry->buffer = entries;
-        return logger->log(logger, info,
-            "LIST  Added \"%s\" to %s", value, entry->key
-        );
+
+
+/**
+ * @brief Gets the token that ends a map or list the token starts, if it starts one.
+ */
+static yaml_token_type_t nested_end(const yaml_token_type_t start) {
+    switch (start) {
+        case YAML_BLOCK_MAPPING_START_TOKEN:
+        case YAML_BLOCK_SEQUENCE_START_TOKEN:
+            return YAML_BLOCK_END_TOKEN;
+        case YAML_FLOW_MAPPING_START_TOKEN:
+            return YAML_FLOW_MAPPING_END_TOKEN;
+        case YAML_FLOW_SEQUENCE_START_TOKEN:
+            return YAML_FLOW_SEQUENCE_END_TOKEN;
+        default:
+            return YAML_NO_TOKEN;
     }
+}
 
-    char** entries = malloc(sizeof(char*));
-    entry->buffer = entries;
-    logger->log(logger, info,
-        "LIST  Allocated list: %s", entry->key
-    );
-    follow_list(entry, value, logger);
-    return true;
+
+/**
+ * @brief Skips the tokens of a map or list that is not awaited, including all nested in it.
+ */
+static void skip_nested(yaml_parser_t* parser) {
+    size_t depth = 1;
+    yaml_token_t token;
+    while (depth > 0 && yaml_parser_scan(parser, &token) &&
+        token.type != YAML_NO_TOKEN && token.type != YAML_STREAM_END_TOKEN
+    ) {
+        if (nested_end(token.type) != YAML_NO_TOKEN) depth++;
+        else if (
+            token.type == YAML_BLOCK_END_TOKEN ||
+            token.type == YAML_FLOW_MAPPING_END_TOKEN ||
+            token.type == YAML_FLOW_SEQUENCE_END_TOKEN
+        ) depth--;
+        yaml_token_delete(&token);
+    }
+    if (depth > 0) yaml_token_delete(&token);
+}
+
+
+/**
+ * @brief Adds the scalars of a list to the list entry until the list ends.
+ */
+static bool scan_list(
+    yaml_parser_t* parser,
+    parse_entry_t* entry,
+    const yaml_token_type_t end,
+    arena_t* arena,
+    logger_t* logger
+) {
+    bool result = true;
+    yaml_token_t token;
+    while (yaml_parser_scan(parser, &token) &&
+        token.type != YAML_NO_TOKEN && token.type != end
+    ) {
+        if (token.type == YAML_SCALAR_TOKEN) result = follow_list(
+            entry, (char*)token.data.scalar.value, arena, logger
+        ) && result;
+        else if (nested_end(token.type) != YAML_NO_TOKEN) skip_nested(parser);
+        yaml_token_delete(&token);
+    }
+    yaml_token_delete(&token);
+    return result;
 }
 
 
+/**
+ * @brief Scans the value that started with the token for the entry, or skips it if there is no entry.
+ *
+ * @return Returns if the token was a value, otherwise it is left untouched.
+ */
+static bool scan_value(
+    yaml_parser_t* parser,
+    const parse_state_t state,
+    parse_entry_t* entry,
+    const struct table_s* table,
+    const yaml_token_t* token,
+    logger_t* logger
+) {
+    const yaml_token_type_t end = nested_end(token->type);
+    if (token->type == YAML_SCALAR_TOKEN) {
+        if (entry) scalar(
+            entry, (char*)token->data.scalar.value, state.arena, logger
+        );
+    } else if (end == YAML_NO_TOKEN) {
+        return false;
+    } else if (entry && entry->type == map && table && (
+        token->type == YAML_BLOCK_MAPPING_START_TOKEN ||
+        token->type == YAML_FLOW_MAPPING_START_TOKEN
+    )) {
+        further_entries(
+            entry, table, state.level, end, parser, state.arena, logger
+        );
+    } else if (entry && is_list(entry->type) && (
+        token->type == YAML_BLOCK_SEQUENCE_START_TOKEN ||
+        token->type == YAML_FLOW_SEQUENCE_START_TOKEN
+    )) {
+        if (!scan_list(parser, entry, end, state.arena, logger)) logger_log(
+            logger, error, "Can't put the values in list context of %s.",
+            entry->key
+        );
+    } else {
+        if (entry) logger_log(logger, error,
+            "The value of %s has not the awaited type.", entry->key
+        );
+        skip_nested(parser);
+    }
+    return true;
+}
+
 
 static bool scan_recursive(
     yaml_parser_t* parser,
     const parse_state_t state,
     logger_t* logger
 ) {
-    logger->log(logger, info,
-        "Scan for %d entries at level %d...",
-        state.size, state.level
+    logger_log(logger, info,
+        "Scan for %zu entries at level %d...",
+        state.table->length, state.level
     );
-    yaml_token_t token, next;
-    char* key = NULL;
-    while (token.type != state.end && next.type != state.end) {
+
+    // The key is looked up as soon as it is scanned and not kept,
+    // tokens that do not belong to a value are scanned again as next token.
+    yaml_token_t token = { .type = YAML_NO_TOKEN };
+    yaml_token_t next = { .type = YAML_NO_TOKEN };
+    parse_entry_t* entry = NULL;
+    const struct table_s* table = NULL;
+    bool result = true;
+    bool rescan = false;
+    while (true) {
+        if (!rescan) {
+            yaml_token_delete(&token);
+            if (!yaml_parser_scan(parser, &token) || token.type == YAML_NO_TOKEN) {
+                result = false;
+                break;
+            }
+        }
+        rescan = false;
+        if (token.type == state.end) break;
+
         if (
             token.type == YAML_ALIAS_TOKEN ||
             token.type == YAML_TAG_TOKEN ||
             token.type == YAML_ANCHOR_TOKEN
-        ) logger->log(logger, error,
+        ) logger_log(logger, error,
             "Aliases, tags and anchors are not supported.");
 
-        if (&token) yaml_token_delete(&token);
-        if (&next) yaml_token_delete(&next);
-        yaml_parser_scan(parser, &token);
-
         if (token.type == YAML_KEY_TOKEN) {
             yaml_parser_scan(parser, &next);
-            if (key) free(key);
-            key = strdup((char*)next.data.scalar.value);
+            entry = next.type != YAML_SCALAR_TOKEN ? NULL : get_entry(
+                state.table, &table,
+                (char*)next.data.scalar.value, next.data.scalar.length
+            );
+            yaml_token_delete(&next);
             continue;
         }
 
-        parse_entry_t* entry = get_entry(
-            key, state.entries, state.size
-        );
-        if (!entry) continue;
+        if (token.type == YAML_VALUE_TOKEN || token.type == YAML_BLOCK_ENTRY_TOKEN) {
+            yaml_parser_scan(parser, &next);
+
+            // Entries of lists without indentation follow their key directly.
+            if (token.type == YAML_BLOCK_ENTRY_TOKEN &&
+                next.type == YAML_SCALAR_TOKEN
+            ) {
+                if (entry && !follow_list(
+                    entry, (char*)next.data.scalar.value, state.arena, logger
+                )) logger_log(
+                    logger, error,
+                    "Can't put the value in list context of %s: %s",
+                    entry->key, (char*)next.data.scalar.value
+                );
+                yaml_token_delete(&next);
+                continue;
+            }
 
-        if (token.type == YAML_BLOCK_MAPPING_START_TOKEN) {
-            further_entries(entry, state.level, parser, logger);
+            if (scan_value(parser, state, entry, table, &next, logger)) {
+                yaml_token_delete(&next);
+                continue;
+            }
+
+            // The value is empty, the token after it is scanned again.
+            yaml_token_delete(&token);
+            token = next;
+            next = (yaml_token_t) { .type = YAML_NO_TOKEN };
+            rescan = true;
+            continue;
         }
 
-        else if (token.type == YAML_VALUE_TOKEN) {
-            yaml_parser_scan(parser, &next);
+        if (nested_end(token.type) != YAML_NO_TOKEN)
+            scan_value(parser, state, entry, table, &token, logger);
+    }
 
-            if (!next.data.scalar.value) further_entries(
-                entry, state.level, parser, logger
-            );
-            else scalar(entry, (char*)next.data.scalar.value, logger);
+    yaml_token_delete(&token);
+    if (!result) return logger_log(logger, error,
+        "Scan of level %d ended before its end.", state.level
+    );
+    return logger_log(logger, info,
+        "Scan of level %d is done.",
+        state.level
+    );
+}
+
+
+/**
+ * @brief Count of 64 byte blocks the structural index of json is filled with at once.
+ */
+#define JSON_INDEX_BLOCKS 16
+
+/**
+ * @brief State of a json document and of the part of its structural index that is filled.
+ *
+ * The index is filled block by block while the document is read, so
+ * only its positions of up to JSON_INDEX_BLOCKS blocks are kept.
+ * A position is at a structural character outside of strings, at a
+ * quote that is not escaped or at the first character of a scalar.
+ * The carries hold what the last block leaves to the next one.
+ */
+struct json_s {
+    const char* input;
+    size_t size;
+    size_t offset;
+    size_t positions[JSON_INDEX_BLOCKS * 64];
+    size_t count;
+    size_t cursor;
+    uint64_t prev_escaped;
+    uint64_t prev_in_string;
+    uint64_t prev_scalar;
+    char* scratch;
+    size_t scratch_capacity;
+    arena_t* arena;
+    logger_t* logger;
+};
+
+
+
+#ifdef _MSC_VER
+#include <intrin.h>
+
+static int first_bit(const uint64_t mask) {
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return index;
+}
+
+
+#else
+
+static int first_bit(const uint64_t mask) {
+    return __builtin_ctzll(mask);
+}
+
+#endif
+
+
+
+/**
+ * @brief Gets the characters that are escaped by an odd count of backslashes before them.
+ *
+ * Backslashes that start at an even bit end at an odd bit if their
+ * count is odd, the carry of the addition finds the end of every
+ * sequence at once. An escaped backslash at the end of the last block
+ * is carried over.
+ */
+static uint64_t json_escaped(uint64_t backslashes, uint64_t* prev_escaped) {
+    const uint64_t even_bits = 0x5555555555555555ULL;
+    backslashes &= ~*prev_escaped;
+    const uint64_t follows_escape = backslashes << 1 | *prev_escaped;
+    const uint64_t odd_starts = backslashes & ~even_bits & ~follows_escape;
+
+    const uint64_t sequences_on_even = odd_starts + backslashes;
+    *prev_escaped = sequences_on_even < odd_starts;
+    return (even_bits ^ sequences_on_even << 1) & follows_escape;
+}
+
+/**
+ * @brief Sets every bit that has an odd count of set bits up to and including it.
+ */
+static uint64_t prefix_xor(uint64_t bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+/**
+ * @brief Fills the index with the positions of the next blocks that have any.
+ *
+ * The last block is padded with spaces.
+ *
+ * @return Returns if there is any position left.
+ */
+static bool json_index(struct json_s* json) {
+    json->count = 0;
+    json->cursor = 0;
+    while (json->count == 0 && json->offset < json->size) {
+        str_json_masks_t masks[JSON_INDEX_BLOCKS];
+        size_t block_count = (json->size - json->offset) / 64;
+        if (block_count > JSON_INDEX_BLOCKS) block_count = JSON_INDEX_BLOCKS;
+        if (block_count > 0) {
+            str_json_classify(json->input + json->offset, block_count, masks);
+        } else {
+            char tail[64];
+            memset(tail, ' ', sizeof(tail));
+            memcpy(tail, json->input + json->offset, json->size - json->offset);
+            str_json_classify(tail, 1, masks);
+            block_count = 1;
         }
 
-        else if (token.type == YAML_BLOCK_ENTRY_TOKEN) {
-            yaml_parser_scan(parser, &next);
+        for (size_t i = 0; i < block_count; i++, json->offset += 64) {
+            const uint64_t quotes = masks[i].quotes &
+                ~json_escaped(masks[i].backslashes, &json->prev_escaped);
+            const uint64_t in_string = prefix_xor(quotes) ^ json->prev_in_string;
+            json->prev_in_string = (uint64_t)((int64_t)in_string >> 63);
 
-            if (!next.data.scalar.value) continue;
-            const bool result = follow_list(
-                entry, (char*)next.data.scalar.value, logger
+            const uint64_t scalars = ~(
+                in_string | quotes | masks[i].structurals | masks[i].spaces
             );
+            const uint64_t scalar_starts = scalars &
+                ~(scalars << 1 | json->prev_scalar);
+            json->prev_scalar = scalars >> 63;
 
-            if (!result) logger->log(
-                logger, error,
-                "Can't put the value in list context of %s: %s",
-                entry->key, (char*)next.data.scalar.value
-            );
+            uint64_t marks = (masks[i].structurals & ~in_string) |
+                quotes | scalar_starts;
+            while (marks) {
+                json->positions[json->count++] = json->offset + first_bit(marks);
+                marks &= marks - 1;
+            }
         }
     }
+    return json->count > 0;
+}
 
-    if (key) free(key);
-    return logger->log(logger, info,
-        "Scan of level %d is done.",
-        state.level
+/**
+ * @brief Gets the next position of the index, or SIZE_MAX at the end of the document.
+ */
+static size_t json_next(struct json_s* json) {
+    if (json->cursor == json->count && !json_index(json)) return SIZE_MAX;
+    return json->positions[json->cursor++];
+}
+
+/**
+ * @brief Gets the next position of the index without moving to it, or the size at the end of the document.
+ */
+static size_t json_peek(struct json_s* json) {
+    if (json->cursor == json->count && !json_index(json)) return json->size;
+    return json->positions[json->cursor];
+}
+
+/**
+ * @brief Gets the character at the position, or zero at the end of the document.
+ */
+static char json_at(const struct json_s* json, const size_t position) {
+    return position < json->size ? json->input[position] : '\0';
+}
+
+/**
+ * @brief Makes room for the size in the scratch buffer.
+ */
+static bool json_reserve(struct json_s* json, const size_t size) {
+    if (size <= json->scratch_capacity) return true;
+    size_t capacity = json->scratch_capacity ? json->scratch_capacity : 256;
+    while (capacity < size) capacity *= 2;
+    char* scratch = realloc(json->scratch, capacity);
+    if (!scratch) return false;
+    json->scratch = scratch;
+    json->scratch_capacity = capacity;
+    return true;
+}
+
+static int hex_digit(const char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') return (c | 0x20) - 'a' + 10;
+    return -1;
+}
+
+/**
+ * @brief Reads the four hex digits of an unicode escape.
+ *
+ * @return Returns the code unit or -1 if they are no hex digits.
+ */
+static long json_code_unit(const char* digits, const char* end) {
+    if (end - digits < 4) return -1;
+    long unit = 0;
+    for (int i = 0; i < 4; i++) {
+        const int digit = hex_digit(digits[i]);
+        if (digit < 0) return -1;
+        unit = unit << 4 | digit;
+    }
+    return unit;
+}
+
+/**
+ * @brief Copies the string into the scratch buffer, resolves its escapes and terminates it.
+ *
+ * Escapes never get longer than they are, so the scratch buffer
+ * needs no more than the length of the string.
+ *
+ * @return Returns the string in the scratch buffer or null if an escape is invalid.
+ */
+static char* json_unescape(
+    struct json_s* json, const char* string, const size_t length
+) {
+    if (!json_reserve(json, length + 1)) return NULL;
+    const char* end = string + length;
+    const char* backslash = memchr(string, '\\', length);
+    if (!backslash) {
+        memcpy(json->scratch, string, length);
+        json->scratch[length] = '\0';
+        return json->scratch;
+    }
+
+    char* out = json->scratch;
+    while (backslash) {
+        memcpy(out, string, backslash - string);
+        out += backslash - string;
+        string = backslash + 2;
+        if (string > end) return NULL;
+        switch (backslash[1]) {
+            case '"': *out++ = '"'; break;
+            case '\\': *out++ = '\\'; break;
+            case '/': *out++ = '/'; break;
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'n': *out++ = '\n'; break;
+            case 'r': *out++ = '\r'; break;
+            case 't': *out++ = '\t'; break;
+            case 'u': {
+                long code = json_code_unit(string, end);
+                if (code < 0) return NULL;
+                string += 4;
+
+                // Characters outside of the basic plane are surrogate pairs.
+                if (code >= 0xD800 && code < 0xDC00) {
+                    const long low = end - string >= 6 &&
+                        string[0] == '\\' && string[1] == 'u' ?
+                        json_code_unit(string + 2, end) : -1;
+                    if (low < 0xDC00 || low > 0xDFFF) return NULL;
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    string += 6;
+                } else if (code >= 0xDC00 && code < 0xE000) return NULL;
+
+                if (code < 0x80) {
+                    *out++ = (char)code;
+                } else if (code < 0x800) {
+                    *out++ = (char)(0xC0 | code >> 6);
+                    *out++ = (char)(0x80 | (code & 0x3F));
+                } else if (code < 0x10000) {
+                    *out++ = (char)(0xE0 | code >> 12);
+                    *out++ = (char)(0x80 | (code >> 6 & 0x3F));
+                    *out++ = (char)(0x80 | (code & 0x3F));
+                } else {
+                    *out++ = (char)(0xF0 | code >> 18);
+                    *out++ = (char)(0x80 | (code >> 12 & 0x3F));
+                    *out++ = (char)(0x80 | (code >> 6 & 0x3F));
+                    *out++ = (char)(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default: return NULL;
+        }
+        backslash = memchr(string, '\\', end - string);
+    }
+    memcpy(out, string, end - string);
+    out[end - string] = '\0';
+    return json->scratch;
+}
+
+/**
+ * @brief Gets the end of the string that starts at the quote, from the position of its closing quote.
+ *
+ * @return Returns SIZE_MAX if the document ends before.
+ */
+static size_t json_string_end(struct json_s* json) {
+    const size_t end = json_next(json);
+    return json_at(json, end) == '"' ? end : SIZE_MAX;
+}
+
+/**
+ * @brief Skips a map or list that is not awaited, including all nested in it.
+ */
+static bool json_skip(struct json_s* json) {
+    size_t depth = 1;
+    while (depth > 0) {
+        const size_t position = json_next(json);
+        switch (json_at(json, position)) {
+            case '{': case '[': depth++; break;
+            case '}': case ']': depth--; break;
+            case '\0': return false;
+            default: break;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Gets the scalar that starts at the position, copied into the scratch buffer.
+ *
+ * The scalar ends with the whitespace before the next position.
+ *
+ * @return Returns the scalar or null if it is null or cannot be copied.
+ */
+static char* json_scalar(struct json_s* json, const size_t position) {
+    size_t end = json_peek(json);
+    while (end > position + 1 && isspace((unsigned char)json->input[end - 1])) end--;
+    if (end - position == 4 && memcmp(json->input + position, "null", 4) == 0)
+        return NULL;
+    return json_unescape(json, json->input + position, end - position);
+}
+
+/**
+ * @brief Gets the scalar or string that starts at the position, unescaped into the scratch buffer.
+ *
+ * @return Returns the value or null if it is null or invalid, which is logged.
+ */
+static char* json_text(struct json_s* json, const size_t position) {
+    if (json->input[position] != '"') return json_scalar(json, position);
+
+    const size_t end = json_string_end(json);
+    char* text = end == SIZE_MAX ? NULL : json_unescape(
+        json, json->input + position + 1, end - position - 1
     );
+    if (!text) logger_log(json->logger, error,
+        "JSON  Invalid string at byte %zu.", position
+    );
+    return text;
 }
 
+static bool json_object(
+    struct json_s* json, const struct table_s* table, int level
+);
 
-bool parse_resolve(
-    const char* string,
-    parse_entry_t* entries,
-    size_t entries_length,
-    logger_t* logger
+/**
+ * @brief Adds the scalars and strings of a list to the list entry until the list ends.
+ */
+static bool json_list(struct json_s* json, parse_entry_t* entry) {
+    size_t position = json_next(json);
+    if (json_at(json, position) == ']') return true;
+
+    bool result = true;
+    while (true) {
+        switch (json_at(json, position)) {
+            case '{': case '[':
+                if (!json_skip(json)) return false;
+                break;
+            case ',': case ':': case ']': case '}': case '\0':
+                return false;
+            default: {
+                const char* value = json_text(json, position);
+                if (value) result = follow_list(
+                    entry, value, json->arena, json->logger
+                ) && result;
+                break;
+            }
+        }
+
+        position = json_next(json);
+        if (json_at(json, position) == ']') return result;
+        if (json_at(json, position) != ',') return false;
+        position = json_next(json);
+    }
+}
+
+/**
+ * @brief Reads the value that starts at the next position for the entry, or skips it if there is no entry.
+ *
+ * @return Returns if the document is valid.
+ */
+static bool json_value(
+    struct json_s* json, parse_entry_t* entry,
+    const struct table_s* table, const int level
+) {
+    const size_t position = json_next(json);
+    const char start = json_at(json, position);
+    if (start == '{' && entry && entry->type == map && table) {
+        logger_log(json->logger, info,
+            "MAP  Start recursive scan for \"%s\"...", entry->key
+        );
+        return json_object(json, table, level + 1);
+    }
+    if (start == '[' && entry && is_list(entry->type)) {
+        if (json_list(json, entry)) return true;
+        return logger_log(json->logger, error,
+            "Can't put the values in list context of %s.", entry->key
+        );
+    }
+    if (start == '{' || start == '[') {
+        if (entry) logger_log(json->logger, error,
+            "The value of %s has not the awaited type.", entry->key
+        );
+        return json_skip(json);
+    }
+    if (start == '\0' || strchr(",:]}", start)) return false;
+
+    const char* value = json_text(json, position);
+    if (value && entry) scalar(entry, value, json->arena, json->logger);
+    return value || start != '"';
+}
+
+/**
+ * @brief Reads the members of a map, after its opening brace, into the entries of the table.
+ */
+static bool json_object(
+    struct json_s* json, const struct table_s* table, const int level
+) {
+    logger_log(json->logger, info,
+        "Scan for %zu entries at level %d...", table->length, level
+    );
+
+    size_t position = json_next(json);
+    if (json_at(json, position) == '}') return true;
+    while (true) {
+        if (json_at(json, position) != '"') break;
+        const size_t end = json_string_end(json);
+        if (end == SIZE_MAX) break;
+
+        // Keys are looked up in place, unless they have escapes.
+        const char* key = json->input + position + 1;
+        size_t length = end - position - 1;
+        if (memchr(key, '\\', length)) {
+            key = json_unescape(json, key, length);
+            if (!key) break;
+            length = strlen(key);
+        }
+        const struct table_s* nested;
+        parse_entry_t* entry = get_entry(table, &nested, key, length);
+
+        if (json_at(json, json_next(json)) != ':' ||
+            !json_value(json, entry, entry ? nested : NULL, level)
+        ) break;
+
+        position = json_next(json);
+        if (json_at(json, position) == '}') return logger_log(json->logger, info,
+            "Scan of level %d is done.", level
+        );
+        if (json_at(json, position) != ',') break;
+        position = json_next(json);
+    }
+    if (position == SIZE_MAX) return logger_log(json->logger, error,
+        "JSON  The document ends before level %d is closed.", level
+    );
+    return logger_log(json->logger, error,
+        "JSON  Unexpected content at byte %zu of level %d.", position, level
+    );
+}
+
+/**
+ * @brief Reads a json document into the entries of the table.
+ *
+ * The structural index is built while the document is read, with the
+ * vector kernels of str_json_classify(), so the values are found
+ * without looking at every byte again.
+ */
+static bool resolve_json(
+    const char* input, const size_t input_size,
+    const struct table_s* table, arena_t* arena, logger_t* logger
 ) {
+    struct json_s* json = malloc(sizeof(struct json_s));
+    if (!json) return logger_log(logger, error,
+        "JSON  State of the document cannot be allocated."
+    );
+    *json = (struct json_s) {
+        .input = input,
+        .size = input_size,
+        .arena = arena,
+        .logger = logger
+    };
+
+    bool result = json_at(json, json_next(json)) == '{' &&
+        json_object(json, table, 0);
+    if (result && json_next(json) != SIZE_MAX) result = logger_log(
+        logger, error, "JSON  There is content after the document."
+    );
+
+    free(json->scratch);
+    free(json);
+    return result;
+}
+
+
+/**
+ * @brief Scans the input for the entries, the input needs no terminating zero.
+ *
+ * Documents whose root is a flow map are read as json, others by the
+ * yaml parser. The source names the input in messages.
+ */
+static bool resolve(
+    const char* input, const size_t input_size, const char* source,
+    const parse_index_t* index, arena_t* arena, logger_t* logger
+) {
+    size_t start = 0;
+    if (input_size >= 3 && memcmp(input, "\xEF\xBB\xBF", 3) == 0) start = 3;
+    while (start < input_size && strchr(" \t\n\r", input[start]) && input[start])
+        start++;
+    if (start < input_size && input[start] == '{') {
+        const bool result = resolve_json(
+            input + start, input_size - start, index->root, arena, logger
+        );
+        if (!result) return logger_log(logger, error,
+            "The following string cannot be resolved as json: %s", source
+        );
+        return logger_log(logger, info, "Parsing process done.");
+    }
 
     yaml_parser_t parser;
     if (!yaml_parser_initialize(&parser))
-        return logger->log(
+        return logger_log(
             logger, error,
             "Yaml parser cannot be initialized."
         );
 
-    char* input = strdup(string);
     yaml_parser_set_input_string(
-        &parser, (unsigned char*)input, sizeof(char) * strlen(string)
+        &parser, (const unsigned char*)input, input_size
     );
 
-    yaml_token_t event;
+    yaml_token_t event = { .type = YAML_NO_TOKEN };
     while (event.type != YAML_BLOCK_MAPPING_START_TOKEN) {
+        yaml_token_delete(&event);
         yaml_parser_scan(&parser, &event);
 
         if (event.type == YAML_NO_TOKEN) {
-            free(input);
-            return logger->log(logger, error,
+            yaml_parser_delete(&parser);
+            return logger_log(logger, error,
                 "The following string cannot be resolved by"
-                "the parser: %s", string
+                "the parser: %s", source
             );
         }
     }
+    yaml_token_delete(&event);
 
     const bool result = scan_recursive(&parser,
         (parse_state_t) {
-            .entries = entries,
+            .table = index->root,
             .level = 0,
-            .size = entries_length,
-            .end = YAML_STREAM_END_TOKEN
+            .end = YAML_STREAM_END_TOKEN,
+            .arena = arena
         }, logger);
 
-    free(input);
-    if (!result) return logger->log(
+    yaml_parser_delete(&parser);
+    if (!result) return logger_log(
         logger, error,
         "Parsing process done."
     );
 
-    yaml_parser_delete(&parser);
-    return logger->log(
+    return logger_log(
         logger, info,
         "Parsing process done."
     );
 }
 
 
+parse_index_t* parse_index_create(
+    parse_entry_t* entries,
+    const size_t entries_length
+) {
+    parse_index_t* index = malloc(sizeof(parse_index_t));
+    arena_t* arena = arena_create(4096);
+    if (index && arena) {
+        *index = (parse_index_t) {
+            .arena = arena,
+            .root = table_create(arena, entries, entries_length, 0)
+        };
+        if (index->root) return index;
+    }
+    free(index);
+    arena_del(arena);
+    return NULL;
+}
+
+
+bool parse_resolve_indexed(
+    const char* input,
+    const size_t input_size,
+    const parse_index_t* index,
+    arena_t* arena,
+    logger_t* logger
+) {
+    return resolve(input, input_size, "input", index, arena, logger);
+}
+
+
+void parse_index_del(parse_index_t* index) {
+    if (!index) return;
+    arena_del(index->arena);
+    free(index);
+}
+
+
+bool parse_resolve(
+    const char* string,
+    parse_entry_t* entries,
+    size_t entries_length,
+    arena_t* arena,
+    logger_t* logger
+) {
+    parse_index_t* index = parse_index_create(entries, entries_length);
+    if (!index) return logger_log(logger, error,
+        "Index of the entries cannot be created."
+    );
+
+    const bool result = resolve(
+        string, strlen(string), string, index, arena, logger
+    );
+    parse_index_del(index);
+    return result;
+}
+
+
+bool parse_resolve_file(
+    const char* path,
+    parse_entry_t* entries,
+    size_t entries_length,
+    arena_t* arena,
+    logger_t* logger
+) {
+    file_view_t view;
+    if (!fview(&view, path)) return logger_log(logger, error,
+        "Configuration file %s cannot be read.", path
+    );
+
+    parse_index_t* index = parse_index_create(entries, entries_length);
+    const bool result = index ? resolve(
+        view.data, view.size, path, index, arena, logger
+    ) : logger_log(logger, error,
+        "Index of the entries cannot be created."
+    );
+    parse_index_del(index);
+    fview_release(&view);
+    return result;
+}
+
+
+
+#ifdef _WIN32
+#include <io.h>
+
+static bool emit_write(const int fd, const char* data, size_t size) {
+    while (size > 0) {
+        const int written = _write(
+            fd, data, size > INT_MAX ? INT_MAX : (unsigned int)size
+        );
+        if (written <= 0) return false;
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+
+#else
+#include <errno.h>
+#include <unistd.h>
+
+static bool emit_write(const int fd, const char* data, size_t size) {
+    while (size > 0) {
+        const ssize_t written = write(fd, data, size);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+#endif
+
+
+
+/**
+ * @brief Size of the chunks documents are written to file descriptors with.
+ */
+#define EMIT_CHUNK_SIZE (16 * 1024)
+
+/**
+ * @brief State of an emission.
+ *
+ * Text is put into the chunk. The chunk of a buffer is its data,
+ * which grows when it is full, the chunk of a file descriptor is
+ * written to it when it is full.
+ */
+struct emitter_s {
+    enum parse_format_e format;
+    parse_buffer_t* buffer;
+    int fd;
+    char* chunk;
+    size_t used;
+    size_t capacity;
+    bool failed;
+    logger_t* logger;
+};
+
+static bool emit_flush(struct emitter_s* emitter) {
+    if (!emitter->buffer) {
+        if (!emit_write(emitter->fd, emitter->chunk, emitter->used))
+            return false;
+        emitter->used = 0;
+        return true;
+    }
+
+    const size_t capacity = emitter->capacity ? emitter->capacity * 2 : 4096;
+    char* data = realloc(emitter->chunk, capacity);
+    if (!data) return false;
+    emitter->chunk = emitter->buffer->data = data;
+    emitter->capacity = emitter->buffer->capacity = capacity;
+    return true;
+}
+
+static void emit(struct emitter_s* emitter, const char* text, size_t length) {
+    while (length > 0 && !emitter->failed) {
+        // Buffers keep a byte for their terminating zero.
+        const size_t limit = !emitter->buffer ? emitter->capacity :
+            emitter->capacity ? emitter->capacity - 1 : 0;
+        if (emitter->used == limit) {
+            emitter->failed = !emit_flush(emitter);
+            continue;
+        }
+
+        const size_t part = limit - emitter->used < length ?
+            limit - emitter->used : length;
+        memcpy(emitter->chunk + emitter->used, text, part);
+        emitter->used += part;
+        text += part;
+        length -= part;
+    }
+}
+
+static void emit_indent(struct emitter_s* emitter, const int level) {
+    static const char spaces[] = "                ";
+    for (size_t rest = level * 2; rest > 0;) {
+        const size_t part = rest < sizeof(spaces) - 1 ? rest : sizeof(spaces) - 1;
+        emit(emitter, spaces, part);
+        rest -= part;
+    }
+}
+
+/**
+ * @brief Emits a string in double quotes, which both formats read the same.
+ *
+ * Characters that need no escape are emitted in runs.
+ */
+static void emit_quoted(struct emitter_s* emitter, const char* string) {
+    emit(emitter, "\"", 1);
+    const char* run = string;
+    for (const char* c = string; *c; c++) {
+        const unsigned char character = *c;
+        if (character >= 0x20 && character != '"' && character != '\\')
+            continue;
+
+        emit(emitter, run, c - run);
+        run = c + 1;
+        char escape[8];
+        if (character == '"') emit(emitter, "\\\"", 2);
+        else if (character == '\\') emit(emitter, "\\\\", 2);
+        else if (character == '\n') emit(emitter, "\\n", 2);
+        else if (character == '\t') emit(emitter, "\\t", 2);
+        else if (character == '\r') emit(emitter, "\\r", 2);
+        else emit(emitter, escape, snprintf(
+            escape, sizeof(escape), "\\u%04x", character
+        ));
+    }
+    emit(emitter, run, strlen(run));
+    emit(emitter, "\"", 1);
+}
+
+/**
+ * @brief Emits a key, plain in yaml if it cannot be read as anything else.
+ */
+static void emit_key(struct emitter_s* emitter, const char* key) {
+    bool plain = emitter->format == yaml &&
+        (isalnum((unsigned char)*key) || *key == '_');
+    for (const char* c = key; plain && *c; c++)
+        plain = isalnum((unsigned char)*c) || *c == '_' || *c == '-' || *c == '.';
+
+    if (plain) emit(emitter, key, strlen(key));
+    else emit_quoted(emitter, key);
+    emit(emitter, ": ", emitter->format == yaml ? 1 : 2);
+}
+
+/**
+ * @brief Emits the shortest form of a float that is read as the same float.
+ */
+static void emit_floating(struct emitter_s* emitter, const double value) {
+    if (isnan(value) || isinf(value)) {
+        const char* text = emitter->format == json ? "null" :
+            isnan(value) ? ".nan" : value > 0 ? ".inf" : "-.inf";
+        emit(emitter, text, strlen(text));
+        return;
+    }
+
+    char text[40];
+    int length = snprintf(text, sizeof(text), "%.15g", value);
+    if (strtod(text, NULL) != value)
+        length = snprintf(text, sizeof(text), "%.17g", value);
+    emit(emitter, text, length);
+    if (!strpbrk(text, ".eE")) emit(emitter, ".0", 2);
+}
+
+/**
+ * @brief Emits the element at the index of a list entry.
+ */
+static void emit_element(
+    struct emitter_s* emitter, const parse_entry_t* entry, const size_t index
+) {
+    if (entry->type == integer_list) {
+        char text[16];
+        emit(emitter, text, snprintf(
+            text, sizeof(text), "%d", ((const int*)entry->buffer)[index]
+        ));
+    } else if (entry->type == floating_list) {
+        emit_floating(emitter, ((const double*)entry->buffer)[index]);
+    } else {
+        emit_quoted(emitter, ((char* const*)entry->buffer)[index]);
+    }
+}
+
+static bool has_value(const parse_entry_t* entry) {
+    return entry->buffer != NULL;
+}
+
+static void emit_entries(
+    struct emitter_s* emitter,
+    const parse_entry_t* entries,
+    size_t entries_length,
+    int level
+);
+
+/**
+ * @brief Emits the value of an entry behind its key, the entry is in a map at the level.
+ */
+static void emit_value(
+    struct emitter_s* emitter, const parse_entry_t* entry, const int level
+) {
+    const bool yaml_format = emitter->format == yaml;
+    if (entry->type == integer) {
+        char text[16];
+        if (yaml_format) emit(emitter, " ", 1);
+        emit(emitter, text, snprintf(
+            text, sizeof(text), "%d", *(const int*)entry->buffer
+        ));
+    }
+
+    else if (entry->type == floating) {
+        if (yaml_format) emit(emitter, " ", 1);
+        emit_floating(emitter, *(const double*)entry->buffer);
+    }
+
+    else if (entry->type == string) {
+        if (yaml_format) emit(emitter, " ", 1);
+        emit_quoted(emitter, entry->buffer);
+    }
+
+    else if (is_list(entry->type)) {
+        if (entry->size == 0) {
+            emit(emitter, yaml_format ? " []" : "[]", yaml_format ? 3 : 2);
+        } else if (yaml_format) {
+            for (size_t i = 0; i < entry->size; i++) {
+                emit(emitter, "\n", 1);
+                emit_indent(emitter, level + 1);
+                emit(emitter, "- ", 2);
+                emit_element(emitter, entry, i);
+            }
+        } else {
+            emit(emitter, "[", 1);
+            for (size_t i = 0; i < entry->size; i++) {
+                emit(emitter, i ? ",\n" : "\n", i ? 2 : 1);
+                emit_indent(emitter, level + 2);
+                emit_element(emitter, entry, i);
+            }
+            emit(emitter, "\n", 1);
+            emit_indent(emitter, level + 1);
+            emit(emitter, "]", 1);
+        }
+    }
+
+    else if (entry->type == map) {
+        const parse_entry_t* nested = entry->buffer;
+        bool empty = true;
+        for (size_t i = 0; i < entry->size && empty; i++)
+            empty = !has_value(&nested[i]);
 
+        if (empty) emit(emitter, yaml_format ? " {}" : "{}", yaml_format ? 3 : 2);
+        else emit_entries(emitter, nested, entry->size, level + 1);
+    }
+}
+
+/**
+ * @brief Emits the entries that have a value as map at the level.
+ *
+ * Yaml maps start on the next line and json maps are in braces,
+ * neither ends with a line break.
+ */
+static void emit_entries(
+    struct emitter_s* emitter,
+    const parse_entry_t* entries,
+    const size_t entries_length,
+    const int level
+) {
+    if (level > PARSE_INDEX_DEPTH) {
+        logger_log(emitter->logger, error,
+            "Maps deeper than %d levels cannot be emitted.", PARSE_INDEX_DEPTH
+        );
+        emitter->failed = true;
+        return;
+    }
 
+    const bool yaml_format = emitter->format == yaml;
+    if (!yaml_format) emit(emitter, "{", 1);
+    bool first = true;
+    for (size_t i = 0; i < entries_length && !emitter->failed; i++) {
+        if (!has_value(&entries[i])) continue;
+        if (!first) emit(emitter, yaml_format ? "\n" : ",\n", yaml_format ? 1 : 2);
+        else if (!yaml_format || level > 0) emit(emitter, "\n", 1);
+        first = false;
 
+        emit_indent(emitter, yaml_format ? level : level + 1);
+        emit_key(emitter, entries[i].key);
+        emit_value(emitter, &entries[i], level);
+    }
+    if (!yaml_format) {
+        emit(emitter, "\n", 1);
+        emit_indent(emitter, level);
+        emit(emitter, "}", 1);
+    }
+}
 
+
+bool parse_emit(
+    parse_buffer_t* buffer,
+    const enum parse_format_e format,
+    const parse_entry_t* entries,
+    const size_t entries_length,
+    logger_t* logger
+) {
+    struct emitter_s emitter = {
+        .format = format,
+        .buffer = buffer,
+        .fd = -1,
+        .chunk = buffer->data,
+        .used = buffer->size,
+        .capacity = buffer->capacity,
+        .failed = false,
+        .logger = logger
+    };
+    emit_entries(&emitter, entries, entries_length, 0);
+    emit(&emitter, "\n", 1);
+    if (emitter.capacity == 0 && !emitter.failed)
+        emitter.failed = !emit_flush(&emitter);
+
+    // The text emitted until a failure is kept.
+    if (emitter.capacity > 0) {
+        emitter.chunk[emitter.used] = '\0';
+        buffer->size = emitter.used;
+    }
+    if (!emitter.failed) return true;
+    logger_log(logger, error, "Document cannot be emitted.");
+    return false;
+}
+
+
+bool parse_emit_fd(
+    const int file_descriptor,
+    const enum parse_format_e format,
+    const parse_entry_t* entries,
+    const size_t entries_length,
+    logger_t* logger
+) {
+    char chunk[EMIT_CHUNK_SIZE];
+    struct emitter_s emitter = {
+        .format = format,
+        .buffer = NULL,
+        .fd = file_descriptor,
+        .chunk = chunk,
+        .used = 0,
+        .capacity = sizeof(chunk),
+        .failed = false,
+        .logger = logger
+    };
+    emit_entries(&emitter, entries, entries_length, 0);
+    emit(&emitter, "\n", 1);
+    if (!emitter.failed) emitter.failed = !emit_flush(&emitter);
+
+    if (!emitter.failed) return true;
+    logger_log(logger, error,
+        "Document cannot be written to %d.", file_descriptor
+    );
+    return false;
+}
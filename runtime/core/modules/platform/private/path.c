@@ -0,0 +1,140 @@
+
+// Copyright (c) 2025 Lenny Siebert
+//
+// This software is dual-licensed:
+//
+// 1. Open Source License:
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License version 3
+//    as published by the Free Software Foundation.
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY. See the GNU General Public
+//    License for more details: https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// 2. Commercial License:
+//    A commercial license will be available at a later time for use in commercial products.
+
+#include "path.h"
+#include "str.h"
+
+
+/**
+ * @brief Makes the path able to hold a length without its terminating zero.
+ *
+ * Paths that do not fit in their storage anymore are moved to the heap,
+ * which grows at least by half of its size.
+ */
+static bool path_reserve(path_t* path, const size_t length) {
+    const size_t capacity = path->heap ? path->capacity : PATH_INLINE_SIZE;
+    if (length < capacity) return true;
+
+    size_t grown = capacity + capacity / 2;
+    if (grown < length + 1) grown = length + 1;
+    char* heap = realloc(path->heap, grown);
+    if (!heap) return false;
+    if (!path->heap) memcpy(heap, path->storage, path->length + 1);
+    path->heap = heap;
+    path->capacity = grown;
+    return true;
+}
+
+char* path_str(const path_t* path) {
+    return path->heap ? path->heap : (char*)path->storage;
+}
+
+bool path_set(path_t* path, const char* string) {
+    path->length = 0;
+    path_str(path)[0] = '\0';
+    return path_append(path, string, strlen(string));
+}
+
+bool path_append(path_t* path, const char* string, const size_t length) {
+    if (!path_reserve(path, path->length + length)) return false;
+
+    char* data = path_str(path);
+    memcpy(data + path->length, string, length);
+    path->length += length;
+    data[path->length] = '\0';
+    return true;
+}
+
+bool path_join(path_t* path, const char* name) {
+    const char* data = path_str(path);
+    const bool separated = path->length == 0 ||
+        data[path->length - 1] == '/' || data[path->length - 1] == '\\';
+    const size_t length = strlen(name);
+    if (!path_reserve(path, path->length + !separated + length)) return false;
+
+    if (!separated) path_append(path, "/", 1);
+    return path_append(path, name, length);
+}
+
+bool path_parent(path_t* path) {
+    char* data = path_str(path);
+    const char* separator = str_last_separator(data, path->length);
+    if (!separator || (separator == data && path->length == 1)) return false;
+
+    // The parent of a file in the root is the root.
+    path->length = separator == data ? 1 : (size_t)(separator - data);
+    data[path->length] = '\0';
+    return true;
+}
+
+const char* path_extension(const path_t* path) {
+    const char* data = path_str(path);
+    const char* separator = str_last_separator(data, path->length);
+    const char* name = separator ? separator + 1 : data;
+    const char* dot = strrchr(name, '.');
+    return dot && dot != name ? dot + 1 : data + path->length;
+}
+
+void path_normalize(path_t* path) {
+    char* data = path_str(path);
+    for (size_t i = 0; i < path->length; i++)
+        if (data[i] == '\\') data[i] = '/';
+
+    // Drives and the root stay in front of all parts.
+    size_t root = 0;
+    if (path->length >= 2 && data[1] == ':') root = 2;
+    if (root < path->length && data[root] == '/') root++;
+    const bool absolute = root > 0 && data[root - 1] == '/';
+
+    // Parts are moved to the front, so the written end never passes the read one.
+    size_t written = root;
+    size_t read = root;
+    while (read < path->length) {
+        size_t end = read;
+        while (end < path->length && data[end] != '/') end++;
+        const size_t start = read;
+        const size_t length = end - start;
+        read = end + 1;
+        if (length == 0 || (length == 1 && data[start] == '.')) continue;
+
+        size_t last = written;
+        while (last > root && data[last - 1] != '/') last--;
+        const bool up = length == 2 && data[start] == '.' && data[start + 1] == '.';
+        const bool last_up = written - last == 2 &&
+            data[last] == '.' && data[last + 1] == '.';
+
+        // Going up from the root stays at the root.
+        if (up && written > root && !last_up) {
+            written = last > root ? last - 1 : root;
+        } else if (!up || !absolute) {
+            if (written > root) data[written++] = '/';
+            memmove(data + written, data + start, length);
+            written += length;
+        }
+    }
+
+    if (written == 0) data[written++] = '.';
+    data[written] = '\0';
+    path->length = written;
+}
+
+void path_release(path_t* path) {
+    free(path->heap);
+    path->heap = NULL;
+    path->capacity = 0;
+    path->length = 0;
+    path->storage[0] = '\0';
+}
@@ -0,0 +1,345 @@
+
+// Copyright (c) 2025 Lenny Siebert
+//
+// This software is dual-licensed:
+//
+// 1. Open Source License:
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License version 3
+//    as published by the Free Software Foundation.
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY. See the GNU General Public
+//    License for more details: https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// 2. Commercial License:
+//    A commercial license will be available at a later time for use in commercial products.
+
+#include "str.h"
+#include <threads.h>
+
+
+/**
+ * @brief The kernels selected for the CPU the program runs on.
+ */
+static struct {
+    void (*lower)(char* output, const char* input, size_t length);
+    const char* (*last_separator)(const char* path, size_t length);
+    void (*json_classify)(
+        const char* input, size_t block_count, str_json_masks_t* masks
+    );
+} kernels;
+
+static once_flag kernels_once = ONCE_FLAG_INIT;
+
+static void lower_scalar(char* output, const char* input, const size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        const unsigned char c = input[i];
+        output[i] = (unsigned)(c - 'A') < 26u ? c | 0x20 : c;
+    }
+}
+
+static const char* last_separator_scalar(const char* path, size_t length) {
+    while (length > 0) {
+        length--;
+        if (path[length] == '/' || path[length] == '\\') return path + length;
+    }
+    return NULL;
+}
+
+
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_AVX2
+
+static int last_bit(const uint32_t mask) {
+    unsigned long index;
+    _BitScanReverse(&index, mask);
+    return index;
+}
+
+static bool supports_avx2(void) {
+    int info[4];
+    __cpuid(info, 1);
+    const bool enabled = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) &&
+        (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return enabled && (info[1] & (1 << 5));
+}
+
+
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+
+static int last_bit(const uint32_t mask) {
+    return 31 - __builtin_clz(mask);
+}
+
+static bool supports_avx2(void) {
+    return __builtin_cpu_supports("avx2");
+}
+
+#endif
+
+// Letters are found with a single signed compare: adding 0x80 - 'A'
+// moves 'A' to -128, so exactly the 26 uppercase letters end up below
+// -128 + 26. Their case bit is set by or.
+
+static void lower_sse2(char* output, const char* input, const size_t length) {
+    const __m128i shift = _mm_set1_epi8(0x80 - 'A');
+    const __m128i bound = _mm_set1_epi8(-128 + 26);
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        const __m128i block = _mm_loadu_si128((const __m128i*)(input + i));
+        const __m128i upper = _mm_cmpgt_epi8(bound, _mm_add_epi8(block, shift));
+        _mm_storeu_si128(
+            (__m128i*)(output + i),
+            _mm_or_si128(block, _mm_and_si128(upper, case_bit))
+        );
+    }
+    lower_scalar(output + i, input + i, length - i);
+}
+
+TARGET_AVX2 static void lower_avx2(
+    char* output, const char* input, const size_t length
+) {
+    const __m256i shift = _mm256_set1_epi8(0x80 - 'A');
+    const __m256i bound = _mm256_set1_epi8(-128 + 26);
+    const __m256i case_bit = _mm256_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        const __m256i block = _mm256_loadu_si256((const __m256i*)(input + i));
+        const __m256i upper = _mm256_cmpgt_epi8(bound, _mm256_add_epi8(block, shift));
+        _mm256_storeu_si256(
+            (__m256i*)(output + i),
+            _mm256_or_si256(block, _mm256_and_si256(upper, case_bit))
+        );
+    }
+
+    // Mixing in legacy SSE code with dirty upper halves stalls.
+    _mm256_zeroupper();
+    lower_sse2(output + i, input + i, length - i);
+}
+
+static const char* last_separator_sse2(const char* path, size_t length) {
+    const __m128i slash = _mm_set1_epi8('/');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    while (length >= 16) {
+        length -= 16;
+        const __m128i block = _mm_loadu_si128((const __m128i*)(path + length));
+        const uint32_t found = _mm_movemask_epi8(_mm_or_si128(
+            _mm_cmpeq_epi8(block, slash), _mm_cmpeq_epi8(block, backslash)
+        ));
+        if (found) return path + length + last_bit(found);
+    }
+    return last_separator_scalar(path, length);
+}
+
+TARGET_AVX2 static const char* last_separator_avx2(
+    const char* path, size_t length
+) {
+    const __m256i slash = _mm256_set1_epi8('/');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    while (length >= 32) {
+        length -= 32;
+        const __m256i block = _mm256_loadu_si256((const __m256i*)(path + length));
+        const uint32_t found = _mm256_movemask_epi8(_mm256_or_si256(
+            _mm256_cmpeq_epi8(block, slash), _mm256_cmpeq_epi8(block, backslash)
+        ));
+        if (found) return path + length + last_bit(found);
+    }
+    _mm256_zeroupper();
+    return last_separator_sse2(path, length);
+}
+
+// Braces and brackets differ from each other only by the bit 0x20,
+// so with that bit set, two compares find all four of them.
+
+static void json_classify_sse2(
+    const char* input, const size_t block_count, str_json_masks_t* masks
+) {
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    for (size_t block = 0; block < block_count; block++, input += 64) {
+        str_json_masks_t found = { 0 };
+        for (int part = 0; part < 4; part++) {
+            const __m128i bytes = _mm_loadu_si128((const __m128i*)(input + part * 16));
+            const __m128i folded = _mm_or_si128(bytes, case_bit);
+            const __m128i structurals = _mm_or_si128(
+                _mm_or_si128(
+                    _mm_cmpeq_epi8(folded, _mm_set1_epi8('{')),
+                    _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'))
+                ),
+                _mm_or_si128(
+                    _mm_cmpeq_epi8(bytes, _mm_set1_epi8(':')),
+                    _mm_cmpeq_epi8(bytes, _mm_set1_epi8(','))
+                )
+            );
+            const __m128i spaces = _mm_or_si128(
+                _mm_or_si128(
+                    _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')),
+                    _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\t'))
+                ),
+                _mm_or_si128(
+                    _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')),
+                    _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\r'))
+                )
+            );
+
+            const int shift = part * 16;
+            found.quotes |= (uint64_t)(uint16_t)_mm_movemask_epi8(
+                _mm_cmpeq_epi8(bytes, _mm_set1_epi8('"'))
+            ) << shift;
+            found.backslashes |= (uint64_t)(uint16_t)_mm_movemask_epi8(
+                _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\\'))
+            ) << shift;
+            found.structurals |=
+                (uint64_t)(uint16_t)_mm_movemask_epi8(structurals) << shift;
+            found.spaces |= (uint64_t)(uint16_t)_mm_movemask_epi8(spaces) << shift;
+        }
+        masks[block] = found;
+    }
+}
+
+TARGET_AVX2 static void json_classify_avx2(
+    const char* input, const size_t block_count, str_json_masks_t* masks
+) {
+    const __m256i case_bit = _mm256_set1_epi8(0x20);
+    for (size_t block = 0; block < block_count; block++, input += 64) {
+        str_json_masks_t found = { 0 };
+        for (int part = 0; part < 2; part++) {
+            const __m256i bytes = _mm256_loadu_si256((const __m256i*)(input + part * 32));
+            const __m256i folded = _mm256_or_si256(bytes, case_bit);
+            const __m256i structurals = _mm256_or_si256(
+                _mm256_or_si256(
+                    _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{')),
+                    _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}'))
+                ),
+                _mm256_or_si256(
+                    _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(':')),
+                    _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(','))
+                )
+            );
+            const __m256i spaces = _mm256_or_si256(
+                _mm256_or_si256(
+                    _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')),
+                    _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\t'))
+                ),
+                _mm256_or_si256(
+                    _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n')),
+                    _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\r'))
+                )
+            );
+
+            const int shift = part * 32;
+            found.quotes |= (uint64_t)(uint32_t)_mm256_movemask_epi8(
+                _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('"'))
+            ) << shift;
+            found.backslashes |= (uint64_t)(uint32_t)_mm256_movemask_epi8(
+                _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\\'))
+            ) << shift;
+            found.structurals |=
+                (uint64_t)(uint32_t)_mm256_movemask_epi8(structurals) << shift;
+            found.spaces |=
+                (uint64_t)(uint32_t)_mm256_movemask_epi8(spaces) << shift;
+        }
+        masks[block] = found;
+    }
+}
+
+static void kernels_select(void) {
+    const bool avx2 = supports_avx2();
+    kernels.lower = avx2 ? lower_avx2 : lower_sse2;
+    kernels.last_separator = avx2 ? last_separator_avx2 : last_separator_sse2;
+    kernels.json_classify = avx2 ? json_classify_avx2 : json_classify_sse2;
+}
+
+
+#else
+
+static void json_classify_scalar(
+    const char* input, const size_t block_count, str_json_masks_t* masks
+) {
+    for (size_t block = 0; block < block_count; block++, input += 64) {
+        str_json_masks_t found = { 0 };
+        for (int i = 0; i < 64; i++) {
+            const uint64_t bit = 1ULL << i;
+            switch (input[i]) {
+                case '"': found.quotes |= bit; break;
+                case '\\': found.backslashes |= bit; break;
+                case '{': case '}': case '[': case ']': case ':': case ',':
+                    found.structurals |= bit;
+                    break;
+                case ' ': case '\t': case '\n': case '\r':
+                    found.spaces |= bit;
+                    break;
+                default: break;
+            }
+        }
+        masks[block] = found;
+    }
+}
+
+static void kernels_select(void) {
+    kernels.lower = lower_scalar;
+    kernels.last_separator = last_separator_scalar;
+    kernels.json_classify = json_classify_scalar;
+}
+
+#endif
+
+
+
+bool str_lower(char* buffer, const size_t buffer_size, const char* string) {
+    const size_t length = strlen(string);
+    if (length >= buffer_size) return false;
+
+    call_once(&kernels_once, kernels_select);
+    kernels.lower(buffer, string, length);
+    buffer[length] = '\0';
+    return true;
+}
+
+bool str_replace(
+    char* buffer, const size_t buffer_size, const char* string,
+    const char* needle, const char* replacement
+) {
+    if (buffer_size == 0) return false;
+    const size_t needle_length = strlen(needle);
+    const size_t replacement_length = strlen(replacement);
+
+    size_t written = 0;
+    const char* rest = string;
+    while (true) {
+        const char* found = needle_length ? strstr(rest, needle) : NULL;
+        const size_t kept = found ? (size_t)(found - rest) : strlen(rest);
+        const size_t added = found ? replacement_length : 0;
+        if (buffer_size - written <= kept + added) {
+            buffer[0] = '\0';
+            return false;
+        }
+
+        memcpy(buffer + written, rest, kept);
+        memcpy(buffer + written + kept, replacement, added);
+        written += kept + added;
+        if (!found) break;
+        rest = found + needle_length;
+    }
+    buffer[written] = '\0';
+    return true;
+}
+
+const char* str_last_separator(const char* path, const size_t length) {
+    call_once(&kernels_once, kernels_select);
+    return kernels.last_separator(path, length);
+}
+
+void str_json_classify(
+    const char* input, const size_t block_count, str_json_masks_t* masks
+) {
+    call_once(&kernels_once, kernels_select);
+    kernels.json_classify(input, block_count, masks);
+}
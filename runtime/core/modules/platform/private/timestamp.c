@@ -0,0 +1,82 @@
+// Copyright (c) 2025 Lenny Siebert
+//
+// This software is dual-licensed:
+//
+// 1. Open Source License:
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License version 3
+//    as published by the Free Software Foundation.
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY. See the GNU General Public
+//    License for more details: https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// 2. Commercial License:
+//    A commercial license will be available at a later time for use in commercial products.
+
+#include "timestamp.h"
+#include <threads.h>
+
+
+/**
+ * @brief Formatted wall-clock time of the last second a thread asked for.
+ */
+static thread_local struct {
+    time_t second;
+    struct tm local;
+    // Fits six numbers of any int value, so the text is never cut.
+    char text[80];
+} wall = { .second = -1 };
+
+const char* timestamp_wall(struct tm* local) {
+    const time_t second = time(NULL);
+    if (second != wall.second) {
+        if (!timestamp_local(second, &wall.local)) return NULL;
+        snprintf(
+            wall.text, sizeof(wall.text), "%02d:%02d:%02d, %02d-%02d-%d",
+            wall.local.tm_hour, wall.local.tm_min, wall.local.tm_sec,
+            wall.local.tm_mday, wall.local.tm_mon + 1,
+            wall.local.tm_year + 1900
+        );
+        wall.second = second;
+    }
+
+    if (local) *local = wall.local;
+    return wall.text;
+}
+
+
+
+#ifdef _WIN32
+#include <windows.h>
+
+bool timestamp_local(const time_t second, struct tm* buffer) {
+    return localtime_s(buffer, &second) == 0;
+}
+
+uint64_t timestamp_mono(void) {
+    static LARGE_INTEGER frequency = { 0 };
+    if (!frequency.QuadPart) QueryPerformanceFrequency(&frequency);
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+
+    const uint64_t seconds = counter.QuadPart / frequency.QuadPart;
+    const uint64_t rest = counter.QuadPart % frequency.QuadPart;
+    return seconds * 1000000000ULL +
+        rest * 1000000000ULL / frequency.QuadPart;
+}
+
+
+#else
+
+bool timestamp_local(const time_t second, struct tm* buffer) {
+    return localtime_r(&second, buffer) != NULL;
+}
+
+uint64_t timestamp_mono(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+#endif
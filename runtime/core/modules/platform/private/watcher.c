@@ -0,0 +1,508 @@
+
+// Copyright (c) 2025 Lenny Siebert
+//
+// This software is dual-licensed:
+//
+// 1. Open Source License:
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License version 3
+//    as published by the Free Software Foundation.
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY. See the GNU General Public
+//    License for more details: https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// 2. Commercial License:
+//    A commercial license will be available at a later time for use in commercial products.
+
+#include "watcher.h"
+#include "str.h"
+#include <sys/stat.h>
+
+
+/**
+ * @brief A file watched by the directory it is in.
+ *
+ * The state is only used if the changes are found by comparison.
+ */
+struct watched_s {
+    char* name;
+    char* path;
+    bool exists;
+    int64_t modified;
+    int64_t size;
+};
+
+/**
+ * @brief A watched directory, either as a whole or for some files in it.
+ */
+struct watch_s {
+    int id;
+    char* dir;
+    size_t dir_length;
+    bool whole;
+    int64_t modified;
+    struct watched_s* files;
+    size_t file_count;
+};
+
+/**
+ * @brief Watches and the events of the current drain.
+ *
+ * The paths of the events are stored one after another, the slots
+ * are an open addressing table of event indices plus one by path,
+ * so all changes of a path are merged into one event.
+ */
+struct file_watcher_s {
+    int fd;
+    struct watch_s* watches;
+    size_t watch_count;
+    file_event_t* events;
+    size_t* offsets;
+    size_t event_count;
+    size_t event_capacity;
+    char* paths;
+    size_t paths_size;
+    size_t paths_capacity;
+    uint32_t* slots;
+    size_t slot_count;
+};
+
+static uint64_t hash_path(const char* path, const size_t length) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)path[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static uint32_t* slot_of(
+    file_watcher_t* watcher, const char* path, const size_t length
+) {
+    const size_t mask = watcher->slot_count - 1;
+    for (size_t i = hash_path(path, length) & mask;; i = (i + 1) & mask) {
+        uint32_t* slot = &watcher->slots[i];
+        if (!*slot) return slot;
+        const char* other = watcher->paths + watcher->offsets[*slot - 1];
+        if (strncmp(other, path, length) == 0 && other[length] == '\0')
+            return slot;
+    }
+}
+
+static bool slots_grow(file_watcher_t* watcher) {
+    const size_t count = watcher->slot_count ? watcher->slot_count * 2 : 64;
+    uint32_t* slots = calloc(count, sizeof(uint32_t));
+    if (!slots) return false;
+    free(watcher->slots);
+    watcher->slots = slots;
+    watcher->slot_count = count;
+
+    for (size_t i = 0; i < watcher->event_count; i++) {
+        const char* path = watcher->paths + watcher->offsets[i];
+        *slot_of(watcher, path, strlen(path)) = i + 1;
+    }
+    return true;
+}
+
+/**
+ * @brief Adds the changes to the event of the path of this drain.
+ *
+ * The path is the directory joined with the name, if the name is set.
+ */
+static bool record(
+    file_watcher_t* watcher, const char* dir, const size_t dir_length,
+    const char* name, const uint32_t changes
+) {
+    const size_t name_length = name ? strlen(name) : 0;
+    const size_t length = dir_length + (name ? name_length + 1 : 0);
+    if (watcher->paths_size + length + 1 > watcher->paths_capacity) {
+        size_t capacity = watcher->paths_capacity ? watcher->paths_capacity : 4096;
+        while (capacity < watcher->paths_size + length + 1) capacity *= 2;
+        char* paths = realloc(watcher->paths, capacity);
+        if (!paths) return false;
+        watcher->paths = paths;
+        watcher->paths_capacity = capacity;
+    }
+
+    // The path is joined behind the others, where it stays if it is new.
+    char* path = watcher->paths + watcher->paths_size;
+    memcpy(path, dir, dir_length);
+    if (name) {
+        path[dir_length] = '/';
+        memcpy(path + dir_length + 1, name, name_length);
+    }
+    path[length] = '\0';
+
+    if ((watcher->event_count + 1) * 2 > watcher->slot_count &&
+        !slots_grow(watcher)
+    ) return false;
+    uint32_t* slot = slot_of(watcher, path, length);
+    if (*slot) {
+        watcher->events[*slot - 1].changes |= changes;
+        return true;
+    }
+
+    if (watcher->event_count == watcher->event_capacity) {
+        const size_t capacity = watcher->event_capacity ?
+            watcher->event_capacity * 2 : 32;
+        file_event_t* events = realloc(
+            watcher->events, capacity * sizeof(file_event_t)
+        );
+        size_t* offsets = realloc(watcher->offsets, capacity * sizeof(size_t));
+        if (events) watcher->events = events;
+        if (offsets) watcher->offsets = offsets;
+        if (!events || !offsets) return false;
+        watcher->event_capacity = capacity;
+    }
+
+    watcher->offsets[watcher->event_count] = watcher->paths_size;
+    watcher->events[watcher->event_count++] = (file_event_t) {
+        .path = NULL,
+        .changes = changes
+    };
+    watcher->paths_size += length + 1;
+    *slot = watcher->event_count;
+    return true;
+}
+
+/**
+ * @brief Gets the watch of the directory or adds a new one.
+ */
+static struct watch_s* watch_of(
+    file_watcher_t* watcher, const int id,
+    const char* dir, const size_t dir_length
+) {
+    for (size_t i = 0; i < watcher->watch_count; i++)
+        if (watcher->watches[i].id == id) return &watcher->watches[i];
+
+    struct watch_s* watches = realloc(
+        watcher->watches, (watcher->watch_count + 1) * sizeof(struct watch_s)
+    );
+    if (!watches) return NULL;
+    watcher->watches = watches;
+
+    char* copy = malloc(dir_length + 1);
+    if (!copy) return NULL;
+    memcpy(copy, dir, dir_length);
+    copy[dir_length] = '\0';
+
+    struct watch_s* watch = &watches[watcher->watch_count++];
+    *watch = (struct watch_s) {
+        .id = id,
+        .dir = copy,
+        .dir_length = dir_length,
+        .whole = false,
+        .modified = 0,
+        .files = NULL,
+        .file_count = 0
+    };
+    return watch;
+}
+
+static struct watched_s* watch_file(
+    struct watch_s* watch, const char* name, const char* path
+) {
+    for (size_t i = 0; i < watch->file_count; i++)
+        if (strcmp(watch->files[i].path, path) == 0) return &watch->files[i];
+
+    struct watched_s* files = realloc(
+        watch->files, (watch->file_count + 1) * sizeof(struct watched_s)
+    );
+    if (!files) return NULL;
+    watch->files = files;
+
+    struct watched_s* file = &files[watch->file_count];
+    *file = (struct watched_s) {
+        .name = strdup(name),
+        .path = strdup(path)
+    };
+    if (!file->name || !file->path) {
+        free(file->name);
+        free(file->path);
+        return NULL;
+    }
+    watch->file_count++;
+    return file;
+}
+
+/**
+ * @brief Splits the path into the length of its directory and its name.
+ *
+ * Paths without a directory are in the working directory.
+ */
+static const char* split(const char* path, const char** dir, size_t* dir_length) {
+    const char* separator = str_last_separator(path, strlen(path));
+    const char* name = separator ? separator + 1 : path;
+
+    if (name == path) {
+        *dir = ".";
+        *dir_length = 1;
+    } else {
+        *dir = path;
+        *dir_length = name - path - 1;
+        if (*dir_length == 0) *dir_length = 1;
+    }
+    return name;
+}
+
+
+
+#ifdef __linux__
+#include <errno.h>
+#include <stdalign.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+/**
+ * @brief Events inotify reports for watched directories.
+ */
+#define WATCH_MASK (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | \
+    IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | \
+    IN_ONLYDIR)
+
+static bool platform_create(file_watcher_t* watcher) {
+    watcher->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watcher->fd < 0) perror("File watcher cannot be created");
+    return watcher->fd >= 0;
+}
+
+static void platform_del(file_watcher_t* watcher) {
+    close(watcher->fd);
+}
+
+static struct watch_s* platform_watch(
+    file_watcher_t* watcher, const char* dir, const size_t dir_length
+) {
+    char* path = strndup(dir, dir_length);
+    if (!path) return NULL;
+    const int id = inotify_add_watch(watcher->fd, path, WATCH_MASK);
+    free(path);
+    if (id < 0) return NULL;
+    return watch_of(watcher, id, dir, dir_length);
+}
+
+static void platform_snapshot(struct watch_s* watch, struct watched_s* file) {
+    (void)watch;
+    (void)file;
+}
+
+static uint32_t changes_of(const uint32_t mask) {
+    uint32_t changes = 0;
+    if (mask & (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB))
+        changes |= change_modified;
+    if (mask & (IN_CREATE | IN_MOVED_TO)) changes |= change_created;
+    if (mask & (IN_DELETE | IN_MOVED_FROM | IN_DELETE_SELF | IN_MOVE_SELF))
+        changes |= change_removed;
+    return changes;
+}
+
+/**
+ * @brief Records the changes of an event to the watched paths it is about.
+ */
+static bool collect_event(
+    file_watcher_t* watcher, const struct inotify_event* event
+) {
+    // Lost events could have been about anything that is watched.
+    if (event->mask & IN_Q_OVERFLOW) {
+        bool result = true;
+        for (size_t i = 0; i < watcher->watch_count && result; i++) {
+            const struct watch_s* watch = &watcher->watches[i];
+            if (watch->whole) result = record(
+                watcher, watch->dir, watch->dir_length, NULL, change_modified
+            );
+            for (size_t j = 0; j < watch->file_count && result; j++)
+                result = record(
+                    watcher, watch->files[j].path,
+                    strlen(watch->files[j].path), NULL, change_modified
+                );
+        }
+        return result;
+    }
+
+    struct watch_s* watch = NULL;
+    for (size_t i = 0; i < watcher->watch_count && !watch; i++)
+        if (watcher->watches[i].id == event->wd) watch = &watcher->watches[i];
+    if (!watch) return true;
+
+    const uint32_t changes = changes_of(event->mask);
+    if (event->mask & IN_IGNORED) watch->id = -1;
+    if (!changes) return true;
+
+    if (event->len == 0) return !watch->whole || record(
+        watcher, watch->dir, watch->dir_length, NULL, changes
+    );
+    if (watch->whole && !record(
+        watcher, watch->dir, watch->dir_length, event->name, changes
+    )) return false;
+
+    for (size_t i = 0; i < watch->file_count; i++)
+        if (strcmp(watch->files[i].name, event->name) == 0) return record(
+            watcher, watch->files[i].path, strlen(watch->files[i].path),
+            NULL, changes
+        );
+    return true;
+}
+
+static bool platform_collect(file_watcher_t* watcher) {
+    alignas(struct inotify_event) char buffer[64 * 1024];
+    while (true) {
+        const ssize_t length = read(watcher->fd, buffer, sizeof(buffer));
+        if (length < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN;
+        }
+        if (length == 0) return true;
+
+        for (ssize_t offset = 0; offset < length;) {
+            const struct inotify_event* event =
+                (const struct inotify_event*)(buffer + offset);
+            if (!collect_event(watcher, event)) return false;
+            offset += sizeof(struct inotify_event) + event->len;
+        }
+    }
+}
+
+
+#else
+
+static bool platform_create(file_watcher_t* watcher) {
+    watcher->fd = -1;
+    return true;
+}
+
+static void platform_del(file_watcher_t* watcher) {
+    (void)watcher;
+}
+
+static struct watch_s* platform_watch(
+    file_watcher_t* watcher, const char* dir, const size_t dir_length
+) {
+    for (size_t i = 0; i < watcher->watch_count; i++) {
+        const struct watch_s* watch = &watcher->watches[i];
+        if (watch->dir_length == dir_length &&
+            memcmp(watch->dir, dir, dir_length) == 0
+        ) return &watcher->watches[i];
+    }
+    return watch_of(watcher, (int)watcher->watch_count, dir, dir_length);
+}
+
+/**
+ * @brief Remembers the state the watched file or directory has now.
+ */
+static void platform_snapshot(struct watch_s* watch, struct watched_s* file) {
+    struct stat attributes;
+    if (!file) {
+        if (stat(watch->dir, &attributes) == 0)
+            watch->modified = attributes.st_mtime;
+        return;
+    }
+
+    file->exists = stat(file->path, &attributes) == 0;
+    file->modified = file->exists ? attributes.st_mtime : 0;
+    file->size = file->exists ? attributes.st_size : 0;
+}
+
+static bool platform_collect(file_watcher_t* watcher) {
+    for (size_t i = 0; i < watcher->watch_count; i++) {
+        struct watch_s* watch = &watcher->watches[i];
+        if (watch->whole) {
+            const int64_t modified = watch->modified;
+            platform_snapshot(watch, NULL);
+            if (modified != watch->modified && !record(
+                watcher, watch->dir, watch->dir_length, NULL, change_modified
+            )) return false;
+        }
+
+        for (size_t j = 0; j < watch->file_count; j++) {
+            struct watched_s* file = &watch->files[j];
+            const struct watched_s last = *file;
+            platform_snapshot(watch, file);
+
+            uint32_t changes = 0;
+            if (!last.exists && file->exists) changes = change_created;
+            else if (last.exists && !file->exists) changes = change_removed;
+            else if (file->exists && (
+                last.modified != file->modified || last.size != file->size
+            )) changes = change_modified;
+            if (changes && !record(
+                watcher, file->path, strlen(file->path), NULL, changes
+            )) return false;
+        }
+    }
+    return true;
+}
+
+#endif
+
+
+
+file_watcher_t* file_watcher_create(void) {
+    file_watcher_t* watcher = calloc(1, sizeof(file_watcher_t));
+    if (!watcher) {
+        perror("File watcher cannot be created");
+        return NULL;
+    }
+    if (platform_create(watcher)) return watcher;
+    free(watcher);
+    return NULL;
+}
+
+bool file_watcher_add(file_watcher_t* watcher, const char* path) {
+    struct stat attributes;
+    if (stat(path, &attributes) == 0 && S_ISDIR(attributes.st_mode)) {
+        size_t length = strlen(path);
+        while (length > 1 && (path[length - 1] == '/' || path[length - 1] == '\\'))
+            length--;
+        struct watch_s* watch = platform_watch(watcher, path, length);
+        if (!watch) return false;
+        watch->whole = true;
+        platform_snapshot(watch, NULL);
+        return true;
+    }
+
+    const char* dir;
+    size_t dir_length;
+    const char* name = split(path, &dir, &dir_length);
+    struct watch_s* watch = platform_watch(watcher, dir, dir_length);
+    if (!watch) return false;
+
+    struct watched_s* file = watch_file(watch, name, path);
+    if (!file) return false;
+    platform_snapshot(watch, file);
+    return true;
+}
+
+size_t file_watcher_drain(file_watcher_t* watcher, const file_event_t** events) {
+    if (watcher->event_count > 0)
+        memset(watcher->slots, 0, watcher->slot_count * sizeof(uint32_t));
+    watcher->event_count = 0;
+    watcher->paths_size = 0;
+
+    if (!platform_collect(watcher))
+        perror("Changes of watched files cannot be read");
+
+    for (size_t i = 0; i < watcher->event_count; i++)
+        watcher->events[i].path = watcher->paths + watcher->offsets[i];
+    *events = watcher->events;
+    return watcher->event_count;
+}
+
+void file_watcher_del(file_watcher_t* watcher) {
+    if (!watcher) return;
+    platform_del(watcher);
+    for (size_t i = 0; i < watcher->watch_count; i++) {
+        struct watch_s* watch = &watcher->watches[i];
+        for (size_t j = 0; j < watch->file_count; j++) {
+            free(watch->files[j].name);
+            free(watch->files[j].path);
+        }
+        free(watch->files);
+        free(watch->dir);
+    }
+    free(watcher->watches);
+    free(watcher->events);
+    free(watcher->offsets);
+    free(watcher->paths);
+    free(watcher->slots);
+    free(watcher);
+}
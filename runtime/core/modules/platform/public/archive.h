@@ -0,0 +1,117 @@
+
+// Copyright (c) 2025 Lenny Siebert
+//
+// This software is dual-licensed:
+//
+// 1. Open Source License:
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License version 3
+//    as published by the Free Software Foundation.
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY. See the GNU General Public
+//    License for more details: https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// 2. Commercial License:
+//    A commercial license will be available at a later time for use in commercial products.
+
+#pragma once
+
+/**
+ * @brief Assets packed into a single file, read through a mapping of it.
+ *
+ * The table of contents is sorted by path and indexed by the hashes of
+ * the paths, so assets are found without searching and without any call
+ * to the file system. The data of every asset is aligned to 64 bytes.
+ * Archives are written in the byte order of the machine that packs them.
+ */
+typedef struct archive_s archive_t;
+
+
+/**
+ * @brief An asset in an archive.
+ *
+ * Path and data point into the archive and are valid until it is
+ * disposed. Paths are relative to the packed directory, separated by
+ * slashes and terminated by a zero byte, the data is not.
+ */
+typedef struct {
+    const char* path;
+    size_t path_length;
+    const void* data;
+    size_t size;
+} archive_asset_t;
+
+
+/**
+ * @brief Packs all files in a directory and its subdirectories into an archive.
+ *
+ * Meant to be run offline, when assets are built.
+ *
+ * @param archive_path Path of the archive that will be created.
+ * @param dir_path Path of the directory that will be packed.
+ * @return Returns if the archive is written.
+ */
+bool archive_pack(const char* archive_path, const char* dir_path);
+
+
+/**
+ * @brief Opens an archive by mapping it.
+ *
+ * The table of contents is checked once, so a damaged archive
+ * is rejected instead of being read out of bounds later.
+ *
+ * @param path Path of the archive.
+ * @return Returns the archive or null if it cannot be opened or is damaged.
+ */
+archive_t* archive_open(const char* path);
+
+
+/**
+ * @brief Finds an asset by its path.
+ *
+ * @param archive The archive the asset is in.
+ * @param path Path of the asset, relative to the packed directory.
+ * @param asset Gets the asset if it is found.
+ * @return Returns if the asset is found.
+ */
+bool archive_find(const archive_t* archive, const char* path, archive_asset_t* asset);
+
+
+/**
+ * @brief Gets the count of assets in an archive.
+ *
+ * @param archive The archive which assets will be counted.
+ * @return Returns the count of assets.
+ */
+size_t archive_count(const archive_t* archive);
+
+
+/**
+ * @brief Gets an asset by its index in the order of paths.
+ *
+ * @param archive The archive the asset is in.
+ * @param index Index of the asset, less than the count of assets.
+ * @param asset Gets the asset.
+ */
+void archive_at(const archive_t* archive, size_t index, archive_asset_t* asset);
+
+
+/**
+ * @brief Finds the assets which paths start with a prefix, like a directory.
+ *
+ * The assets have consecutive indices, as the paths are sorted.
+ *
+ * @param archive The archive the assets are in.
+ * @param prefix Prefix of the paths, like "textures/".
+ * @param first Gets the index of the first asset.
+ * @return Returns the count of the assets.
+ */
+size_t archive_prefix(const archive_t* archive, const char* prefix, size_t* first);
+
+
+/**
+ * @brief Unmaps and disposes the archive.
+ *
+ * @param archive The archive which will be freed.
+ */
+void archive_del(archive_t* archive);
@@ -0,0 +1,76 @@
+
+// Copyright (c) 2025 Lenny Siebert
+//
+// This software is dual-licensed:
+//
+// 1. Open Source License:
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License version 3
+//    as published by the Free Software Foundation.
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY. See the GNU General Public
+//    License for more details: https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// 2. Commercial License:
+//    A commercial license will be available at a later time for use in commercial products.
+
+#pragma once
+
+/**
+ * @brief Bump allocator for many small allocations with the same lifetime.
+ *
+ * Memory is taken from large blocks and is only given back
+ * all at once, when the arena is disposed.
+ */
+typedef struct arena_s arena_t;
+
+
+/**
+ * @brief Creates a new arena.
+ *
+ * @param block_size Size of the blocks the arena allocates from. Larger allocations get a block of their own.
+ * @return Returns the new arena or null if it cannot be allocated.
+ */
+arena_t* arena_create(size_t block_size);
+
+
+/**
+ * @brief Allocates memory from the arena.
+ *
+ * @param arena The arena the memory will be taken from.
+ * @param size Size of the memory.
+ * @param alignment Alignment of the memory, a power of two.
+ * @return Returns the memory or null if no block can be allocated.
+ */
+void* arena_alloc(arena_t* arena, size_t size, size_t alignment);
+
+
+/**
+ * @brief Copies a string into the arena.
+ *
+ * @param arena The arena the copy will be taken from.
+ * @param string The string that will be copied.
+ * @param length Length of the string without the terminating zero.
+ * @return Returns the zero terminated copy or null if no block can be allocated.
+ */
+char* arena_strndup(arena_t* arena, const char* string, size_t length);
+
+
+/**
+ * @brief Moves all memory of an arena to another one.
+ *
+ * The memory stays valid and is released with the destination.
+ * The source arena is disposed.
+ *
+ * @param destination The arena that will own the memory.
+ * @param source The arena which memory will be moved.
+ */
+void arena_adopt(arena_t* destination, arena_t* source);
+
+
+/**
+ * @brief Disposes the arena and all memory allocated from it.
+ *
+ * @param arena The arena which will be freed.
+ */
+void arena_del(arena_t* arena);
@@ -0,0 +1,123 @@
+
+// Copyright (c) 2025 Lenny Siebert
+//
+// This software is dual-licensed:
+//
+// 1. Open Source License:
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License version 3
+//    as published by the Free Software Foundation.
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY. See the GNU General Public
+//    License for more details: https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// 2. Commercial License:
+//    A commercial license will be available at a later time for use in commercial products.
+
+#pragma once
+
+/**
+ * @brief Engine that reads and writes files in the background.
+ *
+ * On Linux, requests are passed to the kernel by io_uring.
+ * Elsewhere, or if io_uring is not available, a pool of threads
+ * performs them with positioned reads and writes.
+ */
+typedef struct async_io_s async_io_t;
+
+
+/**
+ * @brief The operation of an I/O request.
+ */
+typedef enum {
+    io_read,
+    io_write
+} io_operation_t;
+
+
+typedef struct io_request_s io_request_t;
+
+
+/**
+ * @brief Callback for a completed request.
+ *
+ * It is called by async_io_poll() on the polling thread.
+ */
+typedef void (*io_callback_t) (io_request_t* request);
+
+
+/**
+ * @brief A read or write of a file at an offset.
+ *
+ * The file is a descriptor as returned by fileno(). The request and
+ * its buffer must stay valid until it is done. Once done, the result is
+ * the count of transferred bytes, which can be less than the size just
+ * like with pread, or a negative error number.
+ */
+typedef struct io_request_s {
+    io_operation_t operation;
+    int file;
+    void* buffer;
+    size_t size;
+    uint64_t offset;
+    io_callback_t callback;
+    void* user_data;
+    int64_t result;
+    bool done;
+} io_request_t;
+
+
+/**
+ * @brief Creates a new I/O engine.
+ *
+ * Requests are submitted and polled by the same thread.
+ *
+ * @param depth Count of requests that can be in flight at once.
+ * @param thread_count Count of threads that perform requests if io_uring is not available.
+ * @return Returns the new engine or null if it cannot be created.
+ */
+async_io_t* async_io_create(size_t depth, size_t thread_count);
+
+
+/**
+ * @brief Tests if the engine passes its requests to io_uring.
+ *
+ * @param io The engine that will be tested.
+ * @return Returns false if the engine uses its threads.
+ */
+bool async_io_uring(const async_io_t* io);
+
+
+/**
+ * @brief Submits a batch of requests.
+ *
+ * Requests that do not fit in the depth of the engine are not
+ * submitted, poll completed ones and submit the rest again.
+ *
+ * @param io The engine that will perform the requests.
+ * @param requests The requests that will be submitted in order.
+ * @param count Length of the requests array.
+ * @return Returns the count of submitted requests.
+ */
+size_t async_io_submit(async_io_t* io, io_request_t* const* requests, size_t count);
+
+
+/**
+ * @brief Finishes the completed requests.
+ *
+ * Every completed request is marked as done and its callback is called.
+ * Call it once per frame to pick up what finished in the meantime.
+ *
+ * @param io The engine which completed requests will be finished.
+ * @param wait If the call waits for a request to complete, if none has yet.
+ * @return Returns the count of finished requests.
+ */
+size_t async_io_poll(async_io_t* io, bool wait);
+
+
+/**
+ * @brief Waits for all submitted requests and disposes the engine.
+ *
+ * @param io The engine which will be freed.
+ */
+void async_io_del(async_io_t* io);
@@ -0,0 +1,111 @@
+
+// Copyright (c) 2025 Lenny Siebert
+//
+// This software is dual-licensed:
+//
+// 1. Open Source License:
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License version 3
+//    as published by the Free Software Foundation.
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY. See the GNU General Public
+//    License for more details: https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// 2. Commercial License:
+//    A commercial license will be available at a later time for use in commercial products.
+
+#pragma once
+
+#include "logger.h"
+
+/**
+ * @brief Records the messages of the logger to a binary file.
+ *
+ * Instead of formatting a message, only the id of its format string,
+ * the significance, the monotonic stamp and the raw bytes of the
+ * arguments are recorded. Format strings are recorded once, the first
+ * time they are used. Text is only rendered by binary_log_decode().
+ *
+ * Integers are widened to 64 bit and strings are copied,
+ * so the arguments can be used right after the call.
+ * The file is written in the byte order of the machine.
+ *
+ * @param logger The logger which will get the binary target.
+ * @param file The file the records will be written to.
+ * @return Returns if the binary target is set.
+ */
+bool logger_mk_binary(logger_t* logger, FILE* file);
+
+
+/**
+ * @brief Records a message to the binary target.
+ *
+ * @param binary The binary target of a logger.
+ * @param sign Importance of the message.
+ * @param stamp Monotonic stamp of the message in nanoseconds.
+ * @param format Format string of the message, which arguments are recorded.
+ * @param args Arguments of the format string.
+ * @return Returns if the record was written.
+ */
+bool binary_log_write(
+    binary_log_t* binary, logger_significance_t sign, uint64_t stamp,
+    const char* format, va_list args
+);
+
+
+/**
+ * @brief Records a sequence of messages to the binary target.
+ *
+ * @param binary The binary target of a logger.
+ * @param sign Importance of the messages.
+ * @param stamp Monotonic stamp of the sequence in nanoseconds.
+ * @param messages Messages that will be copied in the record.
+ * @param message_count Length of the messages array.
+ * @return Returns if the record was written.
+ */
+bool binary_log_write_sequence(
+    binary_log_t* binary, logger_significance_t sign, uint64_t stamp,
+    char** messages, size_t message_count
+);
+
+
+/**
+ * @brief Records a batch of messages to the binary target.
+ *
+ * Every message is recorded as an argument of a plain format,
+ * so it decodes to its own line.
+ *
+ * @param binary The binary target of a logger.
+ * @param sign Importance of the messages.
+ * @param stamp Monotonic stamp of the batch in nanoseconds.
+ * @param messages Messages that will be copied in the records.
+ * @param message_count Length of the messages array.
+ * @return Returns if the records were written.
+ */
+bool binary_log_write_batch(
+    binary_log_t* binary, logger_significance_t sign, uint64_t stamp,
+    const char* const* messages, size_t message_count
+);
+
+
+/**
+ * @brief Flushes and frees the binary target. The file is not closed.
+ *
+ * @param binary The binary target of a logger.
+ */
+void binary_log_del(binary_log_t* binary);
+
+
+/**
+ * @brief Renders a binary log into the text format of the logger.
+ *
+ * This is the offline part of the binary target. Every record is
+ * formatted to a line just like logger_write() would have written it.
+ *
+ * The binary log is viewed with fview(), so it is not copied.
+ *
+ * @param binary_path Path of the file written by a binary target.
+ * @param text_file File the text lines will be written to.
+ * @return Returns if the whole binary log was valid and decoded.
+ */
+bool binary_log_decode(const char* binary_path, FILE* text_file);
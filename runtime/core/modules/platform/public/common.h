@@ -14,44 +14,166 @@
 // 2. Commercial License:
 //    A commercial license will be available at a later time for use in commercial products.
 
+#pragma once
+
 /**
  * @brief Lowercases a string independent of platform.
+ *
+ * Use str_lower() to write into a buffer instead of a new allocation.
+ *
  * @param string Input string.
- * @return Output string.
+ * @return Output string, which has to be freed, or null if it cannot be allocated.
  */
 char* str_to_lower(const char* string);
 
 /**
  * @brief Gets the parent path of a path.
+ *
+ * Use path_parent() to shorten a path_t in place.
+ *
  * @param path Path of entity which parent path will be written to the buffer.
- * @param buffer Buffer that will get the parent path.
- * @return Returns if the process was successful.
+ * @param buffer Buffer that will get the parent path, at least as large as the path. Can be the path itself.
+ * @return Returns if the path has a parent.
  */
 bool superior_path(char* buffer, const char* path);
 
 
 /**
  * @brief Writes the content of the file to the buffer.
+ *
+ * The content is cut to fit and always terminated by a zero byte.
+ * Use fview() for files of unknown size.
+ *
  * @param file The file that content will be get.
  * @param buffer Pointer to the buffer.
- * @param buffer_size Max length of the buffer.
+ * @param buffer_size Max length of the buffer, including the terminating zero.
  * @return If the function proceed successful.
  */
 bool fcontent(
     char* buffer, size_t buffer_size, FILE* file
 );
 
+/**
+ * @brief Read-only content of a whole file.
+ *
+ * Mapped views point into the mapping of the file. The others own a
+ * buffer the file was read into at once, which is terminated by a zero
+ * byte. Mapped data is not terminated, so always respect the size.
+ */
+typedef struct {
+    const char* data;
+    size_t size;
+    bool mapped;
+} file_view_t;
+
+
+/**
+ * @brief Gets the content of a file without copying it.
+ *
+ * The file is mapped read-only. If it cannot be mapped,
+ * its content is read with a single bulk read instead.
+ *
+ * @param view The view that will be set.
+ * @param path Path of the file that will be viewed.
+ * @return Returns if the view is set.
+ */
+bool fview(file_view_t* view, const char* path);
+
+
+/**
+ * @brief Unmaps or frees the content of a view.
+ *
+ * @param view The view which content will be released.
+ */
+void fview_release(file_view_t* view);
+
+
 /**
  * @brief Copies a file.
+ *
+ * The whole file is copied, regardless of the position of the stream,
+ * which is not moved. The copy is done by the kernel where possible,
+ * as a reflink that shares the blocks or with copy_file_range and
+ * sendfile, otherwise in large chunks.
+ *
  * @param source_file File content that will be copied.
  * @param destination_path Full path of the file that will be created.
+ * @param copied Gets the count of copied bytes, even if the copy failed. Can be null.
  * @return Returns if the process was successful.
  */
-bool fcopy(FILE* source_file, const char* destination_path);
+bool fcopy(
+    FILE* source_file, const char* destination_path, uint64_t* copied
+);
+
+/**
+ * @brief A piece of memory that is written together with others.
+ */
+typedef struct {
+    const void* data;
+    size_t size;
+} io_vector_t;
+
+
+/**
+ * @brief Writes multiple pieces of memory with a single vectored write.
+ *
+ * Buffered data of the file is flushed first and the file stays locked
+ * while writing, so the pieces are not interleaved with other writes
+ * to the same file. Falls back to buffered writes where writev is missing.
+ *
+ * @param file The file the pieces will be written to.
+ * @param vectors The pieces that will be written in order.
+ * @param count Length of the vectors array.
+ * @return Returns if all pieces were written.
+ */
+bool fwrite_vectored(FILE* file, const io_vector_t* vectors, size_t count);
+
+
+/**
+ * @brief Content that will replace a file.
+ */
+typedef struct {
+    const char* path;
+    const void* data;
+    size_t size;
+} file_write_t;
+
+
+/**
+ * @brief Replaces a file, so after a crash it has either its old or its new content.
+ *
+ * The content is written with one write to a temporary file in the same
+ * directory and synced to the disk. Then it is renamed over the file and
+ * the directory is synced, so the rename is on the disk too.
+ * A replaced file keeps its permissions.
+ *
+ * @param path Path of the file that will be replaced or created.
+ * @param data The new content.
+ * @param size Size of the content.
+ * @return Returns if the file is replaced, it is untouched otherwise.
+ */
+bool fwrite_atomic(const char* path, const void* data, size_t size);
+
+
+/**
+ * @brief Replaces many files like fwrite_atomic(), but syncs each directory once.
+ *
+ * All contents are on the disk before the first file is replaced.
+ * Files that cannot be written are skipped and stay untouched.
+ *
+ * @param writes The files and their new content.
+ * @param count Length of the writes array.
+ * @return Returns the count of replaced files.
+ */
+size_t fwrite_atomic_batch(const file_write_t* writes, size_t count);
+
 
 /**
  * @brief Gets the directory the program runs at.
  *
+ * The directory is looked up at every call, as it can be changed.
+ * Use info_dir() for the one the program started at without any lookup.
+ *
  * @param buffer The buffer the path will be written to.
  * @param buffer_size Size of the buffer.
  * @return Returns if the buffer is set.
@@ -62,9 +184,11 @@ bool work_dir(char* buffer, size_t buffer_size);
 /**
  * @brief Gets the directory the execute is in.
  *
+ * The directory is copied from info_dir(), so it is only looked up once.
+ *
  * @param buffer The buffer the path will be written to.
  * @param buffer_size Size of the buffer.
- * @return Returns if the buffer is set.
+ * @return Returns if the buffer is set and the path was not cut to fit.
  */
 bool exe_dir(char* buffer, size_t buffer_size);
 
@@ -90,6 +214,8 @@ bool make_dir(const char* path);
 /**
  * @brief Gets the files by path in a directory.
  *
+ * Every path is allocated on its own. Use dir_walk() for large or nested directories.
+ *
  * @param buffer Buffer the found file paths will be saved to.
  * @param dir_path Path of the directory that will be scanned.
  * @return Returns the length of the buffer array, which is the count of found files.
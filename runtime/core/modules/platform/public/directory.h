@@ -0,0 +1,85 @@
+
+// Copyright (c) 2025 Lenny Siebert
+//
+// This software is dual-licensed:
+//
+// 1. Open Source License:
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License version 3
+//    as published by the Free Software Foundation.
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY. See the GNU General Public
+//    License for more details: https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// 2. Commercial License:
+//    A commercial license will be available at a later time for use in commercial products.
+
+#pragma once
+
+#include "arena.h"
+
+/**
+ * @brief What a directory entry is.
+ *
+ * Links are not followed, so they are never files or directories.
+ */
+typedef enum {
+    entry_file,
+    entry_directory,
+    entry_link,
+    entry_other
+} dir_entry_type_t;
+
+
+/**
+ * @brief An entry found in a directory tree.
+ *
+ * The path is the path of the walked directory joined with the path of
+ * the entry inside of it, its name starts at the name offset.
+ */
+typedef struct {
+    const char* path;
+    uint32_t length;
+    uint32_t name;
+    dir_entry_type_t type;
+} dir_entry_t;
+
+
+/**
+ * @brief The entries of a directory tree.
+ *
+ * All paths are allocated from the arena of the listing.
+ */
+typedef struct {
+    dir_entry_t* entries;
+    size_t count;
+    arena_t* arena;
+} dir_listing_t;
+
+
+/**
+ * @brief Gets the entries of a directory, and of all directories in it if recursive.
+ *
+ * Every directory is read once. The type an entry has in the directory
+ * is trusted, it is only looked up on file systems that do not tell it.
+ * With more than one thread, the directories are read in parallel,
+ * so the entries are in no particular order.
+ *
+ * @param listing The listing that will get the entries.
+ * @param dir_path Path of the directory that will be walked.
+ * @param recursive If the directories found will be walked too.
+ * @param thread_count Count of threads that read directories, the calling thread is one of them.
+ * @return Returns if the directory could be read. Directories below that cannot be read are skipped.
+ */
+bool dir_walk(
+    dir_listing_t* listing, const char* dir_path,
+    bool recursive, size_t thread_count
+);
+
+
+/**
+ * @brief Frees the entries and paths of a listing.
+ *
+ * @param listing The listing which entries will be freed.
+ */
+void dir_listing_release(dir_listing_t* listing);
@@ -0,0 +1,43 @@
+
+// Copyright (c) 2025 Lenny Siebert
+//
+// This software is dual-licensed:
+//
+// 1. Open Source License:
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License version 3
+//    as published by the Free Software Foundation.
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY. See the GNU General Public
+//    License for more details: https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// 2. Commercial License:
+//    A commercial license will be available at a later time for use in commercial products.
+
+#pragma once
+
+/**
+ * @brief Directories the platform tells the program about.
+ */
+typedef enum {
+    location_work,
+    location_executable,
+    location_config,
+    location_cache,
+    location_temp
+} info_location_t;
+
+
+/**
+ * @brief Gets a directory of the platform.
+ *
+ * All directories are looked up once, at the first call, and kept
+ * for the lifetime of the program. The working directory is the one
+ * the program had at that time, use work_dir() for the current one.
+ * The config and cache directories are the ones of the user, not of
+ * the program. They have no separator at their end.
+ *
+ * @param location The directory that will be get.
+ * @return Returns the path, which is never freed or changed, or null if the platform has none.
+ */
+const char* info_dir(info_location_t location);
@@ -14,6 +14,8 @@
 // 2. Commercial License:
 //    A commercial license will be available at a later time for use in commercial products.
 
+#pragma once
+
 /**
  * @brief The importance of a message.
  *
@@ -28,9 +30,54 @@ typedef enum {
 } logger_significance_t;
 
 
+/**
+ * @brief Least important significance that is compiled in.
+ *
+ * Calls of logger_log() with a less important significance are removed
+ * at compile time and their arguments are never evaluated.
+ * Set it at build time to the value of a significance,
+ * e.g. 2 to keep critical, error and warning messages only.
+ */
+#ifndef LOGGER_LEVEL
+#define LOGGER_LEVEL 4
+#endif
+
+
 typedef struct logger_s logger_t;
 
 
+/**
+ * @brief What an asynchronous logger does if the ring buffer of a thread is full.
+ *
+ * Block lets the calling thread wait until the flusher made room,
+ * drop discards the message and drop_info only discards info messages
+ * while the more important ones still wait for room.
+ */
+typedef enum {
+    overflow_block,
+    overflow_drop,
+    overflow_drop_info
+} logger_overflow_t;
+
+
+/**
+ * @brief Ring buffers and flusher thread of an asynchronous logger.
+ */
+typedef struct logger_async_s logger_async_t;
+
+
+/**
+ * @brief Binary file target that defers the formatting of messages.
+ */
+typedef struct binary_log_s binary_log_t;
+
+
+/**
+ * @brief Path and limits of a log file that is rotated.
+ */
+typedef struct logger_rotation_s logger_rotation_t;
+
+
 /**
  * @brief Callback for a logger function.
  *
@@ -45,17 +92,24 @@ typedef bool (*logger_callback_t) (
 /**
  * @brief Represents a logger, its conditionals and targets.
  *
- * The time is the last time a message was sent.
+ * Messages less important than the level are discarded before they are formatted.
  * If the file is set, it will get the messages.
+ * If async is set, the messages are written by a flusher thread.
+ * If binary is set, the messages are recorded unformatted to it and
+ * only formatted if stdout or the file should get them too.
+ * If rotation is set, the file is owned and archived once it is full.
  */
 typedef struct logger_s {
     const char* name;
-    struct tm* time;
     FILE* file;
     bool own_file;
     bool verbose;
     bool print_out;
+    logger_significance_t level;
     logger_callback_t log;
+    logger_async_t* async;
+    binary_log_t* binary;
+    logger_rotation_t* rotation;
 } logger_t;
 
 
@@ -66,6 +120,7 @@ typedef struct logger_s {
  * It is regardless if your set verbose and should_print_in_console,
  * if you create your own logger_log_function that ignores the fields of the
  * structure they are.
+ * The level of the new logger is info, so no message is discarded.
  *
  * @param name Name of the logger that will be printed.
  * @param verbose If logger_significance_e::note messages should be printed to stdout.
@@ -88,6 +143,9 @@ logger_t* logger_create(
  * This function is simply a wrapper to create a file,
  * checks if the file exists before and then continues with placement
  * as well as sets the logger file field.
+ * An existing file is renamed into the logs directory inside of the
+ * directory path, named after the time in its header.
+ * Every new file starts with a fixed-size header line.
  *
  * @param logger The logger which will get a file target.
  * @param named If the file should be named after the name field of the logger structure.
@@ -114,6 +172,103 @@ void logger_mk_file(
 void logger_add_file(logger_t* logger, FILE* file);
 
 
+/**
+ * @brief Rotates the file of the logger once it is too large or too old.
+ *
+ * The full file is renamed into the logs directory, like an
+ * existing file at logger_mk_file(), and a new one takes its place.
+ * Only files made by logger_mk_file() can be rotated.
+ * The limits are tested after every write, or every pass of the
+ * flusher thread, so a file can exceed them by the last of them.
+ *
+ * @param logger The logger which file will be rotated.
+ * @param max_bytes Size of the written messages that triggers a rotation, zero for no limit.
+ * @param max_age Seconds after the file was opened that trigger a rotation, zero for no limit.
+ * @return Returns if the file of the logger can be rotated.
+ */
+bool logger_mk_rotation(
+    logger_t* logger, size_t max_bytes, uint64_t max_age
+);
+
+
+/**
+ * @brief Writes the file of the logger through mapped, preallocated segments.
+ *
+ * Messages are copied into the mapped segment instead of being
+ * written through the stream, the next segment is preallocated and
+ * mapped once it is full. Pages are written back by the system,
+ * so messages survive if the process dies, logger_flush() and a
+ * rotation write them back at once. The unused rest of the last
+ * segment is cut off if the file is closed, until then the file
+ * ends with zeros.
+ * Only files made by logger_mk_file() can be mapped.
+ *
+ * @param logger The logger which file will be mapped.
+ * @param segment_size Size of a segment. Rounded up to the granularity of the platform.
+ * @return Returns if the file is mapped.
+ */
+bool logger_mk_segments(logger_t* logger, size_t segment_size);
+
+
+/**
+ * @brief Moves the output of the logger to a background flusher thread.
+ *
+ * Every thread that writes to the logger gets its own bounded
+ * lock-free ring buffer, a shard. The flusher thread merges the
+ * shards by the monotonic stamp of the messages and writes them to
+ * stdout and the logger file, so many threads can share the logger
+ * without a lock. Messages longer than a record are truncated.
+ *
+ * @param logger The logger which will write asynchronously.
+ * @param capacity Count of records a shard can hold. Rounded up to a power of two.
+ * @param overflow What happens to messages if the shard is full.
+ * @return Returns if the flusher thread is running.
+ */
+bool logger_mk_async(
+    logger_t* logger, size_t capacity, logger_overflow_t overflow
+);
+
+
+/**
+ * @brief Waits until every message written before is on its targets.
+ *
+ * Synchronous loggers just flush stdout and their file.
+ *
+ * @param logger The logger which targets will be flushed.
+ * @return Returns if the targets are flushed.
+ */
+bool logger_flush(logger_t* logger);
+
+
+/**
+ * @brief Budgets of the logs a directory may keep.
+ *
+ * A budget of zero is no limit. The age is in seconds
+ * since the last time a log was written.
+ */
+typedef struct {
+    size_t max_files;
+    uint64_t max_bytes;
+    uint64_t max_age;
+} logger_retention_t;
+
+
+/**
+ * @brief Removes the oldest logs of the directory until it fits the budgets.
+ *
+ * Only files ending with .log are counted. The directory is read once
+ * and the logs are ordered by the time they were last written, the
+ * newest logs that fit in all budgets together are kept.
+ *
+ * @param log_dir_path The directory in which logs will be cleaned up.
+ * @param retention The budgets of the directory.
+ * @return Returns the count of removed logs or -1 if the directory cannot be read.
+ */
+int logger_retain_logs(
+    const char* log_dir_path, logger_retention_t retention
+);
+
+
 /**
  * @brief Cleans the given directory by last time logs was written.
  *
@@ -144,16 +299,78 @@ bool logger_write(
     const char* format, ...);
 
 
+/**
+ * @brief Writes multiple messages as a single bracketed entry.
+ *
+ * The messages get one shared meta and are written with a single
+ * vectored write per target, without being copied.
+ *
+ * @param logger Logger which consists of the conditions.
+ * @param significance Importance of the messages that will be printed.
+ * @param messages Messages that will be written in order.
+ * @param message_count Length of the messages array.
+ * @return Returns result for error handling.
+ */
 bool logger_write_sequence(
     logger_t* logger, logger_significance_t significance,
     char** messages, size_t message_count
 );
 
 
+/**
+ * @brief Writes multiple messages, each as its own line, at once.
+ *
+ * All lines share the meta of the batch. Every target gets the lines
+ * with a single vectored write, the messages are never concatenated.
+ * Use it to dump large tables without a call per line.
+ *
+ * @param logger Logger which consists of the conditions.
+ * @param significance Importance of the messages that will be printed.
+ * @param messages Messages that will be written in order.
+ * @param message_count Length of the messages array.
+ * @return Returns result for error handling.
+ */
+bool logger_write_batch(
+    logger_t* logger, logger_significance_t significance,
+    const char* const* messages, size_t message_count
+);
+
+
+
+/**
+ * @brief Tests if a message of the significance would reach any target.
+ *
+ * Custom log functions decide on their own, so only the level is tested for them.
+ *
+ * @param logger Logger which consists of the conditions.
+ * @param sign Importance of the message.
+ * @return Returns if the message should be formatted.
+ */
+bool logger_enabled(const logger_t* logger, logger_significance_t sign);
+
+
+/**
+ * @brief Calls the log function of the logger if the message would reach a target.
+ *
+ * Messages less important than LOGGER_LEVEL are compiled out,
+ * the others are tested by logger_enabled() before any argument is
+ * evaluated or formatted. Evaluates to the result of the log function,
+ * or if the message was discarded, if its significance is not error.
+ *
+ * The logger and the significance are evaluated up to three times,
+ * so both must be expressions without side effects.
+ */
+#define logger_log(logger, sign, ...) ( \
+    (sign) <= LOGGER_LEVEL && logger_enabled((logger), (sign)) ? \
+        (logger)->log((logger), (sign), __VA_ARGS__) : \
+        (sign) != error)
+
 
 /**
  * @brief Disposes the logger and closes the file if set.
  *
+ * Asynchronous loggers write all pending messages before
+ * the flusher thread stops.
  * No values of logger should be used after disposal.
  *
  * @param logger The logger which fields will be freed.
@@ -13,6 +13,9 @@
 // 2. Commercial License:
 //    A commercial license will be available at a later time for use in commercial products.
 
+#pragma once
+
+#include "arena.h"
 #include "logger.h"
 
 /**
@@ -31,14 +34,18 @@ enum parse_format_e {
  * the recursive values in it.
  *
  * Lists are an array of unparsed strings of the parsed document.
- * Their buffer should not be set at first definition.
+ * Integer and floating lists are contiguous arrays of int and double,
+ * decoded from the strings. The buffer of all lists should not be set
+ * at first definition.
  */
 enum parse_type_e {
     map,
     integer,
     string,
     floating,
-    list
+    list,
+    integer_list,
+    floating_list
 };
 
 
@@ -55,7 +62,8 @@ enum parse_type_e {
  *
  * The parser scans for the key and decide based on the ParseType
  * what the buffer should be and set it. Buffers can be null even after
- * the parse process, if the value was not found.
+ * the parse process, if the value was not found. All buffers the parser
+ * sets are allocated from the arena it gets, so they are freed with it.
  */
 typedef struct {
     char* key;
@@ -68,30 +76,141 @@ typedef struct {
  * @brief Initialize the yaml parser with the input string and continues with the scan.
  *
  * The entries array buffer will be filled with the found values.
+ * Documents that start with a brace are json and are read without the
+ * yaml parser, by a structural index that is built with vector instructions.
  *
  * @param string String that will be parsed in the entries buffer array.
  * @param entries Buffer array that defines for which values will be looked for and processed.
  * @param entries_length Length of the entries array.
+ * @param arena Arena the values are allocated from.
  * @param logger Defines where information while the process about the processing should go to.
  */
 bool parse_resolve(
     const char* string,
     parse_entry_t* entries,
     size_t entries_length,
+    arena_t* arena,
+    logger_t* logger
+);
+
+/**
+ * @brief Resolves the entries from a file, just like parse_resolve().
+ *
+ * The file is viewed with fview(), so it is parsed without a copy.
+ *
+ * @param path Path of the file that will be parsed in the entries buffer array.
+ * @param entries Buffer array that defines for which values will be looked for and processed.
+ * @param entries_length Length of the entries array.
+ * @param arena Arena the values are allocated from.
+ * @param logger Defines where information while the process about the processing should go to.
+ */
+bool parse_resolve_file(
+    const char* path,
+    parse_entry_t* entries,
+    size_t entries_length,
+    arena_t* arena,
     logger_t* logger
 );
 
 /**
- * @brief Writes the entries to the string buffer with the desired configuration format.
+ * @brief Index over the keys of an entries array and of the arrays of its maps.
+ *
+ * Keys of the document are looked up by their hash instead of being
+ * compared with every key of the entries. The index refers to the
+ * entries, so their keys and maps must not change while it is used.
+ */
+typedef struct parse_index_s parse_index_t;
+
+/**
+ * @brief Creates the index of an entries array, including its maps.
+ *
+ * Create it once to resolve many documents with the same entries.
+ * If a key is in an array more than once, the first entry is used.
+ *
+ * @param entries Buffer array that defines for which values will be looked for and processed.
+ * @param entries_length Length of the entries array.
+ * @return Returns the new index or null if it cannot be allocated.
+ */
+parse_index_t* parse_index_create(parse_entry_t* entries, size_t entries_length);
+
+/**
+ * @brief Resolves the entries of an index, just like parse_resolve().
  *
- * @param buffer String buffer which the emitted yaml will go to.
+ * @param input Input that will be parsed, which needs no terminating zero.
+ * @param input_size Size of the input.
+ * @param index Index of the entries the found values will be filled in.
+ * @param arena Arena the values are allocated from.
+ * @param logger Defines where information while the process about the processing should go to.
+ */
+bool parse_resolve_indexed(
+    const char* input,
+    size_t input_size,
+    const parse_index_t* index,
+    arena_t* arena,
+    logger_t* logger
+);
+
+/**
+ * @brief Disposes an index, but not the entries.
+ *
+ * @param index The index which will be freed.
+ */
+void parse_index_del(parse_index_t* index);
+
+/**
+ * @brief Text that grows while it is emitted.
+ *
+ * Zero it to start with an empty buffer, like `parse_buffer_t buffer = { 0 };`.
+ * The data is terminated by a zero byte, which is not part of the size,
+ * and has to be freed after.
+ */
+typedef struct {
+    char* data;
+    size_t size;
+    size_t capacity;
+} parse_buffer_t;
+
+/**
+ * @brief Writes the entries to the end of a buffer in the desired configuration format.
+ *
+ * Entries without a value are left out, so documents that are resolved
+ * and emitted again keep their keys. Strings are always quoted. The
+ * buffer only grows by doubling and nothing else is allocated, so emit
+ * into the same buffer again to not allocate at all. Write the buffer
+ * with fwrite_atomic() to save it without ever leaving a half file.
+ *
+ * @param buffer Buffer which the emitted document will be appended to.
+ * @param format The configuration format of the document.
  * @param entries Buffer array that define which values will be processed.
  * @param entries_length Length of the entries buffer array.
  * @param logger Defines where information while the process about the processing should go to.
+ * @return Returns if the document is emitted, it can be incomplete otherwise.
  */
-void parse_emit(
-    char* buffer,
+bool parse_emit(
+    parse_buffer_t* buffer,
+    enum parse_format_e format,
     const parse_entry_t* entries,
     size_t entries_length,
-    const logger_t* logger
+    logger_t* logger
+);
+
+/**
+ * @brief Writes the entries to a file descriptor, just like parse_emit().
+ *
+ * The document is written in chunks from a buffer on the stack,
+ * so nothing is allocated.
+ *
+ * @param file_descriptor The file descriptor the document is written to.
+ * @param format The configuration format of the document.
+ * @param entries Buffer array that define which values will be processed.
+ * @param entries_length Length of the entries buffer array.
+ * @param logger Defines where information while the process about the processing should go to.
+ * @return Returns if the document is written, it can be incomplete otherwise.
+ */
+bool parse_emit_fd(
+    int file_descriptor,
+    enum parse_format_e format,
+    const parse_entry_t* entries,
+    size_t entries_length,
+    logger_t* logger
 );
@@ -0,0 +1,118 @@
+
+// Copyright (c) 2025 Lenny Siebert
+//
+// This software is dual-licensed:
+//
+// 1. Open Source License:
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License version 3
+//    as published by the Free Software Foundation.
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY. See the GNU General Public
+//    License for more details: https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// 2. Commercial License:
+//    A commercial license will be available at a later time for use in commercial products.
+
+#pragma once
+
+/**
+ * @brief Size of the storage inside of a path, including the terminating zero.
+ */
+#define PATH_INLINE_SIZE 256
+
+
+/**
+ * @brief A path that is stored inside of itself while it is short.
+ *
+ * Longer paths are moved to the heap and can grow without limit.
+ * The path is always terminated by a zero byte. A zeroed path is empty,
+ * so paths can be declared as `path_t path = { 0 };`. Paths must not
+ * be copied by value, as the copy would share the heap storage.
+ */
+typedef struct {
+    char* heap;
+    size_t length;
+    size_t capacity;
+    char storage[PATH_INLINE_SIZE];
+} path_t;
+
+
+/**
+ * @brief Gets the zero terminated string of a path.
+ *
+ * @param path The path which string will be get.
+ * @return Returns the string, which is valid until the path is changed.
+ */
+char* path_str(const path_t* path);
+
+
+/**
+ * @brief Replaces the path with a string.
+ *
+ * @param path The path that will be set.
+ * @param string The string the path will be set to.
+ * @return Returns if the path is set. It is empty otherwise.
+ */
+bool path_set(path_t* path, const char* string);
+
+
+/**
+ * @brief Appends a string to the path as it is, like an extension.
+ *
+ * @param path The path that will be appended to.
+ * @param string The string that will be appended.
+ * @param length Length of the string.
+ * @return Returns if the string is appended. The path is unchanged otherwise.
+ */
+bool path_append(path_t* path, const char* string, size_t length);
+
+
+/**
+ * @brief Appends a name to the path, separated by a slash.
+ *
+ * No separator is added if the path is empty or already ends with one.
+ *
+ * @param path The path that will be appended to.
+ * @param name Name of a file or directory, or a relative path.
+ * @return Returns if the name is appended. The path is unchanged otherwise.
+ */
+bool path_join(path_t* path, const char* name);
+
+
+/**
+ * @brief Removes the last part of the path, so it becomes the path of its parent.
+ *
+ * @param path The path that will be shortened.
+ * @return Returns if the path has a parent. The path is unchanged otherwise.
+ */
+bool path_parent(path_t* path);
+
+
+/**
+ * @brief Gets the extension of the last part of the path.
+ *
+ * @param path The path which extension will be get.
+ * @return Returns the extension behind the dot or an empty string if there is none.
+ */
+const char* path_extension(const path_t* path);
+
+
+/**
+ * @brief Brings the path into its shortest form with slashes as separators.
+ *
+ * Empty and "." parts are removed, ".." removes the part before it.
+ * The file system is not touched, so links are not resolved.
+ * Relative paths that end up empty become ".".
+ *
+ * @param path The path that will be normalized.
+ */
+void path_normalize(path_t* path);
+
+
+/**
+ * @brief Frees the heap storage of the path and empties it.
+ *
+ * @param path The path which storage will be freed.
+ */
+void path_release(path_t* path);
@@ -0,0 +1,87 @@
+
+// Copyright (c) 2025 Lenny Siebert
+//
+// This software is dual-licensed:
+//
+// 1. Open Source License:
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License version 3
+//    as published by the Free Software Foundation.
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY. See the GNU General Public
+//    License for more details: https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// 2. Commercial License:
+//    A commercial license will be available at a later time for use in commercial products.
+
+#pragma once
+
+// String kernels that process 16 or 32 bytes at once where the CPU
+// supports it, which is detected once at runtime. All functions
+// write into buffers of the caller and never past their size.
+
+
+/**
+ * @brief Lowercases the ASCII letters of a string independent of locale.
+ *
+ * @param buffer Buffer the lowercased string will be written to, can be the string itself.
+ * @param buffer_size Size of the buffer, including the terminating zero.
+ * @param string The string that will be lowercased.
+ * @return Returns if the string fits into the buffer, nothing is written otherwise.
+ */
+bool str_lower(char* buffer, size_t buffer_size, const char* string);
+
+
+/**
+ * @brief Replaces every occurrence of the needle in a string.
+ *
+ * @param buffer Buffer the result will be written to, must not overlap the string.
+ * @param buffer_size Size of the buffer, including the terminating zero.
+ * @param string The string the needle will be replaced in.
+ * @param needle The string that will be replaced, the string is copied if it is empty.
+ * @param replacement The string the needle will be replaced with.
+ * @return Returns if the result fits into the buffer, which is empty otherwise.
+ */
+bool str_replace(
+    char* buffer, size_t buffer_size, const char* string,
+    const char* needle, const char* replacement
+);
+
+
+/**
+ * @brief Finds the last path separator, a slash or backslash.
+ *
+ * @param path The path that will be searched.
+ * @param length Length of the path.
+ * @return Returns the last separator or null if there is none.
+ */
+const char* str_last_separator(const char* path, size_t length);
+
+
+/**
+ * @brief Where the characters that structure JSON are in a block of 64 bytes.
+ *
+ * Bit n of a mask stands for byte n of the block.
+ */
+typedef struct {
+    uint64_t quotes;
+    uint64_t backslashes;
+    uint64_t structurals;
+    uint64_t spaces;
+} str_json_masks_t;
+
+
+/**
+ * @brief Finds quotes, backslashes, structural characters and whitespace in blocks of 64 bytes.
+ *
+ * Structural characters are braces, brackets, colons and commas.
+ * Whether they are inside of strings is not known to a single block,
+ * so it is left to the caller.
+ *
+ * @param input The blocks, which are 64 bytes each.
+ * @param block_count Count of the blocks.
+ * @param masks Gets the masks of every block.
+ */
+void str_json_classify(
+    const char* input, size_t block_count, str_json_masks_t* masks
+);
@@ -0,0 +1,53 @@
+
+// Copyright (c) 2025 Lenny Siebert
+//
+// This software is dual-licensed:
+//
+// 1. Open Source License:
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License version 3
+//    as published by the Free Software Foundation.
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY. See the GNU General Public
+//    License for more details: https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// 2. Commercial License:
+//    A commercial license will be available at a later time for use in commercial products.
+
+#pragma once
+
+/**
+ * @brief Gets the nanoseconds of the monotonic clock.
+ *
+ * The clock never jumps, but its origin is unspecified,
+ * so only the difference between two stamps is meaningful.
+ * Use it to order and diff events within a frame.
+ *
+ * @return Returns the current monotonic stamp in nanoseconds.
+ */
+uint64_t timestamp_mono(void);
+
+
+/**
+ * @brief Gets the formatted local wall-clock time.
+ *
+ * The time is formatted as "hh:mm:ss, dd-mm-yyyy".
+ * Every thread caches the formatted string and only
+ * refreshes it once the second has changed.
+ *
+ * @param local Buffer for the broken-down local time. Can be null.
+ * @return Returns the formatted time, valid until the next call on the same thread.
+ */
+const char* timestamp_wall(struct tm* local);
+
+
+/**
+ * @brief Converts a calendar time to the broken-down local time.
+ *
+ * Thread-safe replacement of localtime().
+ *
+ * @param second The calendar time that will be converted.
+ * @param buffer Buffer for the broken-down local time.
+ * @return Returns if the buffer is set.
+ */
+bool timestamp_local(time_t second, struct tm* buffer);
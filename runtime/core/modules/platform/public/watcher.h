@@ -0,0 +1,93 @@
+
+// Copyright (c) 2025 Lenny Siebert
+//
+// This software is dual-licensed:
+//
+// 1. Open Source License:
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License version 3
+//    as published by the Free Software Foundation.
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY. See the GNU General Public
+//    License for more details: https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// 2. Commercial License:
+//    A commercial license will be available at a later time for use in commercial products.
+
+#pragma once
+
+/**
+ * @brief Watches files and directories for changes.
+ *
+ * On Linux the changes are reported by inotify, so a drain without
+ * changes costs a single read. Elsewhere every watched file is
+ * compared with its last state at each drain.
+ */
+typedef struct file_watcher_s file_watcher_t;
+
+
+/**
+ * @brief What happened to a path, events combine them as flags.
+ */
+typedef enum {
+    change_modified = 1,
+    change_created = 2,
+    change_removed = 4
+} file_change_t;
+
+
+/**
+ * @brief The changes of a path since the last drain.
+ *
+ * All changes of the same path are coalesced in one event.
+ * Files in watched directories are reported with the path of the
+ * directory joined with their name, watched files with their path.
+ * Without inotify, changes in a directory are reported by the
+ * path of the directory itself.
+ */
+typedef struct {
+    const char* path;
+    uint32_t changes;
+} file_event_t;
+
+
+/**
+ * @brief Creates a new watcher without anything to watch.
+ *
+ * @return Returns the new watcher or null if it cannot be created.
+ */
+file_watcher_t* file_watcher_create(void);
+
+
+/**
+ * @brief Starts to watch a file or all files in a directory.
+ *
+ * Files are watched by their directory, so files that are
+ * replaced by renaming a new one over them are still reported.
+ * Directories are not watched recursively.
+ *
+ * @param watcher The watcher that will watch the path.
+ * @param path Path of the file or directory.
+ * @return Returns if the path is watched.
+ */
+bool file_watcher_add(file_watcher_t* watcher, const char* path);
+
+
+/**
+ * @brief Takes all changes since the last drain, without waiting.
+ *
+ * Call it once per frame.
+ *
+ * @param watcher The watcher which changes will be taken.
+ * @param events Gets the events, which are valid until the next drain.
+ * @return Returns the count of events.
+ */
+size_t file_watcher_drain(file_watcher_t* watcher, const file_event_t** events);
+
+
+/**
+ * @brief Stops watching and disposes the watcher.
+ *
+ * @param watcher The watcher which will be freed.
+ */
+void file_watcher_del(file_watcher_t* watcher);
@@ -0,0 +1,749 @@
+
+// Copyright (c) 2025 Lenny Siebert
+//
+// This software is dual-licensed:
+//
+// 1. Open Source License:
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License version 3
+//    as published by the Free Software Foundation.
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY. See the GNU General Public
+//    License for more details: https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// 2. Commercial License:
+//    A commercial license will be available at a later time for use in commercial products.
+
+#include "snapshot.h"
+#include "common.h"
+#include <stdalign.h>
+
+
+#define SNAPSHOT_MAGIC "FWSNAPSH"
+#define SNAPSHOT_VERSION 1
+
+/**
+ * @brief Maps deeper than this are not stored, like the parser does not index them.
+ */
+#define SNAPSHOT_DEPTH 64
+
+/**
+ * @brief Start of every snapshot.
+ *
+ * The entries arrays and their values follow the header, the fixups
+ * are written behind them. A fixup is the offset of a pointer in the
+ * snapshot, which holds the offset of its target or zero for null.
+ * Keys are not stored, the entries are filled by their position and
+ * the layout hash stands for the keys they were written with.
+ */
+struct header_s {
+    char magic[8];
+    uint32_t version;
+    uint16_t pointer_size;
+    uint16_t entry_size;
+    uint64_t size;
+    uint64_t layout;
+    uint64_t source_hash;
+    int64_t source_modified;
+    uint64_t source_size;
+    uint64_t entries;
+    uint64_t entries_length;
+    uint64_t fixups;
+    uint64_t fixup_count;
+};
+
+/**
+ * @brief What the source was when the snapshot was written.
+ */
+struct source_s {
+    uint64_t hash;
+    int64_t modified;
+    uint64_t size;
+};
+
+/**
+ * @brief A snapshot owns either its mapped file or the arena the source was parsed into.
+ */
+struct snapshot_s {
+    char* data;
+    size_t size;
+    bool mapped;
+    arena_t* arena;
+};
+
+/**
+ * @brief A snapshot while it is written, with the offsets of its pointers.
+ */
+struct writer_s {
+    char* data;
+    size_t size;
+    size_t capacity;
+    uint64_t* fixups;
+    size_t fixup_count;
+    size_t fixup_capacity;
+    bool failed;
+};
+
+
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+
+static bool source_stamp(const char* path, struct source_s* source) {
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if (!GetFileAttributesEx(path, GetFileExInfoStandard, &attributes))
+        return false;
+    const uint64_t ticks = (uint64_t)attributes.ftLastWriteTime.dwHighDateTime << 32 |
+        attributes.ftLastWriteTime.dwLowDateTime;
+    source->modified = (int64_t)(ticks - 116444736000000000ULL) * 100;
+    source->size = (uint64_t)attributes.nFileSizeHigh << 32 |
+        attributes.nFileSizeLow;
+    return true;
+}
+
+/**
+ * @brief Maps the file copy on write, so the pointers can be fixed up in place.
+ */
+static bool snapshot_map(struct snapshot_s* snapshot, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    const long long size = _filelengthi64(_fileno(file));
+    if (size < (long long)sizeof(struct header_s)) {
+        fclose(file);
+        return false;
+    }
+
+    const HANDLE mapping = CreateFileMapping(
+        (HANDLE)_get_osfhandle(_fileno(file)),
+        NULL, PAGE_WRITECOPY, 0, 0, NULL
+    );
+    char* data = mapping ? MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0) : NULL;
+    if (mapping) CloseHandle(mapping);
+    if (data) {
+        fclose(file);
+        *snapshot = (struct snapshot_s) {
+            .data = data, .size = size, .mapped = true
+        };
+        return true;
+    }
+
+    data = malloc(size);
+    const bool result = data && fread(data, 1, size, file) == (size_t)size;
+    fclose(file);
+    if (!result) {
+        free(data);
+        return false;
+    }
+    *snapshot = (struct snapshot_s) { .data = data, .size = size };
+    return true;
+}
+
+static void snapshot_unmap(struct snapshot_s* snapshot) {
+    if (snapshot->mapped) UnmapViewOfFile(snapshot->data);
+    else free(snapshot->data);
+}
+
+
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Gets the modification time of the file in nanoseconds since the epoch.
+ */
+static int64_t modified_of(const struct stat* attributes) {
+#ifdef __APPLE__
+    const struct timespec modified = attributes->st_mtimespec;
+#else
+    const struct timespec modified = attributes->st_mtim;
+#endif
+    return (int64_t)modified.tv_sec * 1000000000LL + modified.tv_nsec;
+}
+
+static bool source_stamp(const char* path, struct source_s* source) {
+    struct stat attributes;
+    if (stat(path, &attributes) != 0) return false;
+    source->modified = modified_of(&attributes);
+    source->size = attributes.st_size;
+    return true;
+}
+
+/**
+ * @brief Maps the file copy on write, so the pointers can be fixed up in place.
+ */
+static bool snapshot_map(struct snapshot_s* snapshot, const char* path) {
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat attributes;
+    if (fstat(fd, &attributes) != 0 ||
+        attributes.st_size < (off_t)sizeof(struct header_s)
+    ) {
+        close(fd);
+        return false;
+    }
+
+    const size_t size = attributes.st_size;
+    char* data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED) {
+        close(fd);
+        *snapshot = (struct snapshot_s) {
+            .data = data, .size = size, .mapped = true
+        };
+        return true;
+    }
+
+    data = malloc(size);
+    size_t done = 0;
+    while (data && done < size) {
+        const ssize_t count = read(fd, data + done, size - done);
+        if (count <= 0) break;
+        done += count;
+    }
+    close(fd);
+    if (done < size) {
+        free(data);
+        return false;
+    }
+    *snapshot = (struct snapshot_s) { .data = data, .size = size };
+    return true;
+}
+
+static void snapshot_unmap(struct snapshot_s* snapshot) {
+    if (snapshot->mapped) munmap(snapshot->data, snapshot->size);
+    else free(snapshot->data);
+}
+
+#endif
+
+
+
+/**
+ * @brief Continues the hash with the data, eight bytes at a time.
+ *
+ * Only meant to notice changes, not to withstand anyone who makes them.
+ */
+static uint64_t hash_bytes(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = data;
+    for (; size >= 8; size -= 8, bytes += 8) {
+        uint64_t word;
+        memcpy(&word, bytes, 8);
+        hash = (hash ^ word) * 0x100000001B3ULL;
+        hash ^= hash >> 32;
+    }
+    for (; size > 0; size--, bytes++)
+        hash = (hash ^ *bytes) * 0x100000001B3ULL;
+    return hash;
+}
+
+/**
+ * @brief Hashes the keys and types of the entries, including those of their maps.
+ */
+static uint64_t layout_hash(
+    uint64_t hash, const parse_entry_t* entries,
+    const size_t length, const int depth
+) {
+    for (size_t i = 0; i < length; i++) {
+        const uint8_t type = entries[i].type;
+        hash = hash_bytes(hash, entries[i].key, strlen(entries[i].key) + 1);
+        hash = hash_bytes(hash, &type, 1);
+        if (type != map) continue;
+
+        hash = hash_bytes(hash, "{", 1);
+        if (entries[i].buffer && depth < SNAPSHOT_DEPTH) hash = layout_hash(
+            hash, entries[i].buffer, entries[i].size, depth + 1
+        );
+        hash = hash_bytes(hash, "}", 1);
+    }
+    return hash;
+}
+
+static bool source_hash(const char* path, uint64_t* hash) {
+    file_view_t view;
+    if (!fview(&view, path)) return false;
+    *hash = hash_bytes(14695981039346656037ULL, view.data, view.size);
+    fview_release(&view);
+    return true;
+}
+
+
+
+/**
+ * @brief Appends zeros to the snapshot.
+ *
+ * @return Returns the offset of the zeros, or zero if they cannot be allocated.
+ */
+static size_t writer_reserve(
+    struct writer_s* writer, const size_t size, const size_t alignment
+) {
+    const size_t offset = (writer->size + alignment - 1) & ~(alignment - 1);
+    if (writer->failed) return 0;
+    if (offset + size > writer->capacity) {
+        size_t capacity = writer->capacity ? writer->capacity * 2 : 4096;
+        while (capacity < offset + size) capacity *= 2;
+        char* data = realloc(writer->data, capacity);
+        if (!data) {
+            writer->failed = true;
+            return 0;
+        }
+        writer->data = data;
+        writer->capacity = capacity;
+    }
+    memset(writer->data + writer->size, 0, offset + size - writer->size);
+    writer->size = offset + size;
+    return offset;
+}
+
+static size_t writer_copy(
+    struct writer_s* writer, const void* data,
+    const size_t size, const size_t alignment
+) {
+    const size_t offset = writer_reserve(writer, size, alignment);
+    if (offset) memcpy(writer->data + offset, data, size);
+    return offset;
+}
+
+/**
+ * @brief Stores the offset of the target as pointer at the offset and remembers it for the fixups.
+ */
+static void writer_pointer(
+    struct writer_s* writer, const size_t at, const size_t target
+) {
+    if (writer->failed || !target) return;
+    if (writer->fixup_count == writer->fixup_capacity) {
+        const size_t capacity = writer->fixup_capacity ?
+            writer->fixup_capacity * 2 : 256;
+        uint64_t* fixups = realloc(writer->fixups, capacity * sizeof(uint64_t));
+        if (!fixups) {
+            writer->failed = true;
+            return;
+        }
+        writer->fixups = fixups;
+        writer->fixup_capacity = capacity;
+    }
+    const uintptr_t pointer = target;
+    memcpy(writer->data + at, &pointer, sizeof(pointer));
+    writer->fixups[writer->fixup_count++] = at;
+}
+
+/**
+ * @brief Appends the value of the entry.
+ *
+ * @return Returns the offset of the value, or zero if it is not set.
+ */
+static size_t write_entries(
+    struct writer_s* writer, const parse_entry_t* entries,
+    size_t length, int depth
+);
+
+static size_t write_value(
+    struct writer_s* writer, const parse_entry_t* entry, const int depth
+) {
+    if (!entry->buffer) return 0;
+    switch (entry->type) {
+        case integer:
+            return writer_copy(writer, entry->buffer, sizeof(int), alignof(int));
+        case floating:
+            return writer_copy(
+                writer, entry->buffer, sizeof(double), alignof(double)
+            );
+        case string:
+            return writer_copy(
+                writer, entry->buffer, strlen(entry->buffer) + 1, 1
+            );
+        case integer_list:
+            return writer_copy(
+                writer, entry->buffer, entry->size * sizeof(int), alignof(int)
+            );
+        case floating_list:
+            return writer_copy(
+                writer, entry->buffer,
+                entry->size * sizeof(double), alignof(double)
+            );
+        case list: {
+            char* const* items = entry->buffer;
+            const size_t array = writer_reserve(
+                writer, entry->size * sizeof(char*), alignof(char*)
+            );
+            for (size_t i = 0; i < entry->size; i++) writer_pointer(
+                writer, array + i * sizeof(char*),
+                writer_copy(writer, items[i], strlen(items[i]) + 1, 1)
+            );
+            return array;
+        }
+        case map:
+            if (depth >= SNAPSHOT_DEPTH) return 0;
+            return write_entries(writer, entry->buffer, entry->size, depth + 1);
+    }
+    return 0;
+}
+
+static size_t write_entries(
+    struct writer_s* writer, const parse_entry_t* entries,
+    const size_t length, const int depth
+) {
+    const size_t array = writer_reserve(
+        writer, length * sizeof(parse_entry_t), alignof(parse_entry_t)
+    );
+    for (size_t i = 0; i < length; i++) {
+        const size_t at = array + i * sizeof(parse_entry_t);
+        const size_t buffer = write_value(writer, &entries[i], depth);
+        if (writer->failed) return 0;
+
+        // The data can have moved, so the entry is written after its values.
+        parse_entry_t* entry = (parse_entry_t*)(writer->data + at);
+        entry->type = entries[i].type;
+        entry->size = entries[i].size;
+        writer_pointer(writer, at + offsetof(parse_entry_t, buffer), buffer);
+    }
+    return array;
+}
+
+/**
+ * @brief Writes the snapshot of the entries with the state of their source.
+ */
+static bool write_snapshot(
+    const char* snapshot_path, const struct source_s* source,
+    const parse_entry_t* entries, const size_t entries_length
+) {
+    struct writer_s writer = { 0 };
+    writer_reserve(&writer, sizeof(struct header_s), alignof(struct header_s));
+    const size_t root = write_entries(&writer, entries, entries_length, 0);
+    const size_t fixups = writer_copy(
+        &writer, writer.fixups,
+        writer.fixup_count * sizeof(uint64_t), alignof(uint64_t)
+    );
+
+    bool result = !writer.failed;
+    if (result) {
+        struct header_s header = {
+            .magic = SNAPSHOT_MAGIC,
+            .version = SNAPSHOT_VERSION,
+            .pointer_size = sizeof(void*),
+            .entry_size = sizeof(parse_entry_t),
+            .size = writer.size,
+            .layout = layout_hash(
+                14695981039346656037ULL, entries, entries_length, 0
+            ),
+            .source_hash = source->hash,
+            .source_modified = source->modified,
+            .source_size = source->size,
+            .entries = root,
+            .entries_length = entries_length,
+            .fixups = fixups,
+            .fixup_count = writer.fixup_count
+        };
+        memcpy(writer.data, &header, sizeof(header));
+        result = fwrite_atomic(snapshot_path, writer.data, writer.size);
+    }
+    free(writer.data);
+    free(writer.fixups);
+    return result;
+}
+
+
+
+/**
+ * @brief Tests if the snapshot fits the entries and if its source is unchanged.
+ *
+ * The bounds of the fixups and their targets are checked too, the
+ * values they point to are checked by values_valid() once they are fixed up.
+ * Fixups can only be between the header and the fixups, so fixing up
+ * one can never change the header or another fixup.
+ */
+static bool snapshot_valid(
+    const struct snapshot_s* snapshot, const char* source_path,
+    const parse_entry_t* entries, const size_t entries_length
+) {
+    struct header_s header;
+    memcpy(&header, snapshot->data, sizeof(header));
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, 8) != 0 ||
+        header.version != SNAPSHOT_VERSION ||
+        header.pointer_size != sizeof(void*) ||
+        header.entry_size != sizeof(parse_entry_t) ||
+        header.size != snapshot->size ||
+        header.entries_length != entries_length ||
+        header.entries % alignof(parse_entry_t) != 0 ||
+        header.entries < sizeof(struct header_s) ||
+        header.entries > header.size ||
+        entries_length > (header.size - header.entries) / sizeof(parse_entry_t) ||
+        header.fixups % alignof(uint64_t) != 0 ||
+        header.fixups < header.entries + entries_length * sizeof(parse_entry_t) ||
+        header.fixups > header.size ||
+        header.fixup_count > (header.size - header.fixups) / sizeof(uint64_t) ||
+        header.layout != layout_hash(
+            14695981039346656037ULL, entries, entries_length, 0
+        )
+    ) return false;
+
+    const uint64_t* fixups = (const uint64_t*)(snapshot->data + header.fixups);
+    for (uint64_t i = 0; i < header.fixup_count; i++) {
+        uintptr_t target;
+        if (fixups[i] % alignof(void*) != 0 ||
+            fixups[i] < sizeof(struct header_s) ||
+            fixups[i] > header.fixups - sizeof(void*)
+        ) return false;
+        memcpy(&target, snapshot->data + fixups[i], sizeof(target));
+        if (target > header.size) return false;
+    }
+
+    struct source_s source;
+    if (!source_stamp(source_path, &source) || source.size != header.source_size)
+        return false;
+    if (source.modified == header.source_modified) return true;
+    return source_hash(source_path, &source.hash) &&
+        source.hash == header.source_hash;
+}
+
+/**
+ * @brief Tests if the elements are inside of the snapshot and aligned.
+ */
+static bool span_valid(
+    const struct snapshot_s* snapshot, const void* pointer,
+    const size_t count, const size_t element_size, const size_t alignment
+) {
+    const uintptr_t start = (uintptr_t)snapshot->data;
+    const uintptr_t at = (uintptr_t)pointer;
+    return at >= start && at - start <= snapshot->size &&
+        count <= (snapshot->size - (at - start)) / element_size &&
+        at % alignment == 0;
+}
+
+/**
+ * @brief Tests if the string is inside of the snapshot and terminated in it.
+ */
+static bool string_valid(const struct snapshot_s* snapshot, const char* string) {
+    return span_valid(snapshot, string, 0, 1, 1) && memchr(
+        string, '\0', snapshot->size - (size_t)(string - snapshot->data)
+    );
+}
+
+/**
+ * @brief Tests if the fixed up values of the loaded entries are inside of the snapshot.
+ *
+ * Every array is checked against its size and every string for its
+ * terminating zero, so a damaged snapshot is rejected instead of
+ * being read out of bounds later, by the callers or by parse_emit().
+ */
+static bool values_valid(
+    const struct snapshot_s* snapshot, const parse_entry_t* entries,
+    const parse_entry_t* loaded, const size_t length, const int depth
+) {
+    if (!span_valid(
+        snapshot, loaded, length, sizeof(parse_entry_t), alignof(parse_entry_t)
+    )) return false;
+
+    for (size_t i = 0; i < length; i++) {
+        const parse_entry_t* entry = &loaded[i];
+        if (entry->type != entries[i].type) return false;
+        if (!entry->buffer) continue;
+
+        bool valid = false;
+        switch (entry->type) {
+            case integer:
+                valid = span_valid(snapshot, entry->buffer, 1, sizeof(int), alignof(int));
+                break;
+            case floating:
+                valid = span_valid(
+                    snapshot, entry->buffer, 1, sizeof(double), alignof(double)
+                );
+                break;
+            case string:
+                valid = string_valid(snapshot, entry->buffer);
+                break;
+            case integer_list:
+                valid = span_valid(
+                    snapshot, entry->buffer, entry->size, sizeof(int), alignof(int)
+                );
+                break;
+            case floating_list:
+                valid = span_valid(
+                    snapshot, entry->buffer, entry->size,
+                    sizeof(double), alignof(double)
+                );
+                break;
+            case list: {
+                char* const* items = entry->buffer;
+                valid = span_valid(
+                    snapshot, items, entry->size, sizeof(char*), alignof(char*)
+                );
+                for (size_t j = 0; valid && j < entry->size; j++)
+                    valid = items[j] && string_valid(snapshot, items[j]);
+                break;
+            }
+            case map:
+                valid = !entries[i].buffer || depth >= SNAPSHOT_DEPTH || (
+                    entry->size == entries[i].size && values_valid(
+                        snapshot, entries[i].buffer, entry->buffer,
+                        entry->size, depth + 1
+                    )
+                );
+                break;
+        }
+        if (!valid) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Sets the values of the entries to the ones of the snapshot, the layouts are the same.
+ */
+static void fill_entries(
+    parse_entry_t* entries, const parse_entry_t* loaded,
+    const size_t length, const int depth
+) {
+    for (size_t i = 0; i < length; i++) {
+        if (entries[i].type != map) {
+            entries[i].buffer = loaded[i].buffer;
+            entries[i].size = loaded[i].size;
+        } else if (entries[i].buffer && loaded[i].buffer && depth < SNAPSHOT_DEPTH) {
+            fill_entries(
+                entries[i].buffer, loaded[i].buffer, entries[i].size, depth + 1
+            );
+        }
+    }
+}
+
+/**
+ * @brief Unsets the values of the entries, but not the arrays of their maps.
+ */
+static void clear_entries(
+    parse_entry_t* entries, const size_t length, const int depth
+) {
+    for (size_t i = 0; i < length; i++) {
+        if (entries[i].type != map) {
+            entries[i].buffer = NULL;
+            entries[i].size = 0;
+        } else if (entries[i].buffer && depth < SNAPSHOT_DEPTH) {
+            clear_entries(entries[i].buffer, entries[i].size, depth + 1);
+        }
+    }
+}
+
+/**
+ * @brief Loads the snapshot and turns its offsets into pointers.
+ */
+static bool snapshot_load(
+    struct snapshot_s* snapshot, const char* snapshot_path,
+    const char* source_path, parse_entry_t* entries, const size_t entries_length
+) {
+    if (!snapshot_map(snapshot, snapshot_path)) return false;
+    if (!snapshot_valid(snapshot, source_path, entries, entries_length)) {
+        snapshot_unmap(snapshot);
+        return false;
+    }
+
+    struct header_s header;
+    memcpy(&header, snapshot->data, sizeof(header));
+    const uint64_t* fixups = (const uint64_t*)(snapshot->data + header.fixups);
+    for (uint64_t i = 0; i < header.fixup_count; i++) {
+        uintptr_t pointer;
+        memcpy(&pointer, snapshot->data + fixups[i], sizeof(pointer));
+        pointer += (uintptr_t)snapshot->data;
+        memcpy(snapshot->data + fixups[i], &pointer, sizeof(pointer));
+    }
+
+    const parse_entry_t* loaded =
+        (const parse_entry_t*)(snapshot->data + header.entries);
+    if (!values_valid(snapshot, entries, loaded, entries_length, 0)) {
+        snapshot_unmap(snapshot);
+        return false;
+    }
+    fill_entries(entries, loaded, entries_length, 0);
+    return true;
+}
+
+
+snapshot_t* snapshot_resolve(
+    const char* source_path,
+    const char* snapshot_path,
+    parse_entry_t* entries,
+    size_t entries_length,
+    logger_t* logger
+) {
+    snapshot_t* snapshot = malloc(sizeof(snapshot_t));
+    if (!snapshot) {
+        logger_log(logger, error, "Snapshot of %s cannot be allocated.", source_path);
+        return NULL;
+    }
+
+    if (snapshot_load(
+        snapshot, snapshot_path, source_path, entries, entries_length
+    )) {
+        logger_log(logger, info,
+            "Loaded %s from its snapshot %s.", source_path, snapshot_path
+        );
+        return snapshot;
+    }
+
+    // The state of the source is taken before it is read, so a change
+    // while it is parsed makes the next snapshot stale instead of wrong.
+    struct source_s source;
+    file_view_t view;
+    *snapshot = (struct snapshot_s) { .arena = arena_create(64 * 1024) };
+    parse_index_t* index = parse_index_create(entries, entries_length);
+    if (!snapshot->arena || !index || !source_stamp(source_path, &source) ||
+        !fview(&view, source_path)
+    ) {
+        logger_log(logger, error, "Configuration file %s cannot be read.", source_path);
+        parse_index_del(index);
+        arena_del(snapshot->arena);
+        free(snapshot);
+        return NULL;
+    }
+
+    bool result = parse_resolve_indexed(
+        view.data, view.size, index, snapshot->arena, logger
+    );
+    source.hash = hash_bytes(14695981039346656037ULL, view.data, view.size);
+    parse_index_del(index);
+    fview_release(&view);
+    if (!result) {
+        clear_entries(entries, entries_length, 0);
+        arena_del(snapshot->arena);
+        free(snapshot);
+        return NULL;
+    }
+
+    if (!write_snapshot(snapshot_path, &source, entries, entries_length))
+        logger_log(logger, warning,
+            "Snapshot %s cannot be written.", snapshot_path
+        );
+    return snapshot;
+}
+
+
+bool snapshot_write(
+    const char* snapshot_path,
+    const char* source_path,
+    const parse_entry_t* entries,
+    size_t entries_length,
+    logger_t* logger
+) {
+    struct source_s source;
+    if (!source_stamp(source_path, &source) ||
+        !source_hash(source_path, &source.hash)
+    ) return logger_log(logger, error,
+        "Configuration file %s cannot be read.", source_path
+    );
+
+    if (!write_snapshot(snapshot_path, &source, entries, entries_length))
+        return logger_log(logger, error,
+            "Snapshot %s cannot be written.", snapshot_path
+        );
+    return logger_log(logger, info,
+        "Snapshot %s of %s is written.", snapshot_path, source_path
+    );
+}
+
+
+void snapshot_del(snapshot_t* snapshot) {
+    if (!snapshot) return;
+    if (snapshot->arena) arena_del(snapshot->arena);
+    else snapshot_unmap(snapshot);
+    free(snapshot);
+}
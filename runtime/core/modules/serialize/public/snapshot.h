@@ -0,0 +1,92 @@
+
+// Copyright (c) 2025 Lenny Siebert
+//
+// This software is dual-licensed:
+//
+// 1. Open Source License:
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License version 3
+//    as published by the Free Software Foundation.
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY. See the GNU General Public
+//    License for more details: https://www.gnu.org/licenses/gpl-3.0.en.html
+//
+// 2. Commercial License:
+//    A commercial license will be available at a later time for use in commercial products.
+
+#pragma once
+
+#include "parse.h"
+
+/**
+ * @brief Resolved entries of a configuration file, stored as binary snapshot.
+ *
+ * A snapshot holds the entries tree with all values in a single file,
+ * the pointers of the tree are stored as offsets into the file. It is
+ * loaded by mapping the file and turning the offsets into pointers, so
+ * neither the source is parsed nor anything is allocated per value.
+ * Snapshots remember the modification time, size and hash of their
+ * source and the keys and types of their entries. They are written in
+ * the byte order and pointer size of the machine that resolves them,
+ * so they are caches of a machine, not files to be shipped.
+ */
+typedef struct snapshot_s snapshot_t;
+
+
+/**
+ * @brief Resolves the entries from the snapshot of the source, or from the source itself.
+ *
+ * The snapshot is used if the keys and types of the entries are the
+ * ones it was written with and the source is unchanged. The source is
+ * unchanged if its modification time and size are the same or, if only
+ * its time differs, the hash of its content. Otherwise the source is
+ * parsed like by parse_resolve_file() and a new snapshot is written,
+ * which is only warned about if it fails.
+ *
+ * @param source_path Path of the yaml or json file.
+ * @param snapshot_path Path of the snapshot of the file.
+ * @param entries Buffer array that defines for which values will be looked for and processed.
+ * @param entries_length Length of the entries array.
+ * @param logger Defines where information while the process about the processing should go to.
+ * @return Returns the snapshot which owns the values of the entries until it is disposed, or null if the source cannot be resolved.
+ */
+snapshot_t* snapshot_resolve(
+    const char* source_path,
+    const char* snapshot_path,
+    parse_entry_t* entries,
+    size_t entries_length,
+    logger_t* logger
+);
+
+
+/**
+ * @brief Writes the resolved entries of a source as its snapshot.
+ *
+ * Use it to compile the snapshots of configurations ahead of time.
+ * The snapshot is replaced with fwrite_atomic(), so readers never
+ * see half of it.
+ *
+ * @param snapshot_path Path of the snapshot that will be written.
+ * @param source_path Path of the file the entries were resolved from.
+ * @param entries Buffer array with the resolved values.
+ * @param entries_length Length of the entries array.
+ * @param logger Defines where information while the process about the processing should go to.
+ * @return Returns if the snapshot is written.
+ */
+bool snapshot_write(
+    const char* snapshot_path,
+    const char* source_path,
+    const parse_entry_t* entries,
+    size_t entries_length,
+    logger_t* logger
+);
+
+
+/**
+ * @brief Disposes a snapshot and the values of the entries it resolved.
+ *
+ * No values of the entries should be used after disposal.
+ *
+ * @param snapshot The snapshot which will be unmapped or freed.
+ */
+void snapshot_del(snapshot_t* snapshot);